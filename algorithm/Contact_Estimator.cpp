@@ -0,0 +1,245 @@
+#include "Contact_Estimator.h"
+#include "GT2FIS_Default_Model.h"
+#include "GT2FIS_Model_File.h"
+#include "evaluateMyFIS.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <random>
+
+ContactEstimator::ContactEstimator(int numEndEffectors, size_t stableWindow)
+    : fuzzyModel(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(),
+                 static_cast<int>(GT2FCM_DefaultRuleBase().size())),
+      stableWindow(stableWindow) {
+    if (numEndEffectors <= 0) {
+        throw std::invalid_argument("ContactEstimator needs at least one end-effector");
+    }
+    busFrames.resize(numEndEffectors);
+    endEffectors.reserve(numEndEffectors);
+    for (int i = 0; i < numEndEffectors; i++) {
+        endEffectors.emplace_back(stableWindow);
+    }
+}
+
+void ContactEstimator::setModel(const std::vector<std::vector<std::vector<double>>>& ruleBase,
+                                const std::vector<std::vector<double>>& uncertaintyWeights,
+                                int numMF) {
+    fuzzyModel.setModel(ruleBase, uncertaintyWeights, numMF);
+    decompile();
+}
+
+void ContactEstimator::setFilterParams(double cutoffFreq, double accThreshold) {
+    for (EndEffectorState& state : endEffectors) {
+        state.filter.setFilterParams(cutoffFreq, accThreshold);
+    }
+    filterCutoff = cutoffFreq;
+    filterAccThreshold = accThreshold;
+}
+
+void ContactEstimator::setNormalizationMode(NormalizationMode mode, double decayTime, double percentile) {
+    for (EndEffectorState& state : endEffectors) {
+        state.filter.setNormalizationMode(mode, decayTime, percentile);
+    }
+    normMode = mode;
+    normDecayTime = decayTime;
+    normPercentile = percentile;
+    calibrations.clear();
+}
+
+void ContactEstimator::setCalibration(int idx, const NormalizerCalibration& calibration) {
+    endEffectors.at(idx).filter.setCalibration(calibration);
+    if (calibrations.empty()) {
+        for (const EndEffectorState& state : endEffectors) {
+            calibrations.push_back(state.filter.getCalibration());
+        }
+    }
+    calibrations[idx] = calibration;
+}
+
+void ContactEstimator::loadModel(const char* path) {
+    GT2FCM_ModelFile model(path);
+    if (model.numRules() != numRules || model.inputDim() != inputDim) {
+        throw std::invalid_argument("GT2FCM model dimension does not match ContactEstimator");
+    }
+    std::copy(model.normalization(), model.normalization() + inputDim, normalization.begin());
+    fuzzyModel.setUNR(model.unr(), model.fcmConstant());
+    for (EndEffectorState& state : endEffectors) {
+        state.filter.setNormalization(normalization);
+    }
+    calibrations.clear();
+    decompile();
+}
+
+void ContactEstimator::setStableFIS(const char* jsonPath) {
+    stableFIS.loadConfig(jsonPath);
+    decompile();
+}
+
+double ContactEstimator::squash(double output) const {
+    if (output < pivot) {
+        return 0.5 + 0.5 * tanh(beta_low * (output - pivot));
+    }
+    return 0.5 + 0.5 * tanh(beta_high * (output - pivot));
+}
+
+double ContactEstimator::stableFISExact(const double* x) {
+    if (stableFIS.loaded())
+        return stableFIS.evaluate(x);
+    return evaluateMyFIS(x);
+}
+
+void ContactEstimator::compile(int gt2fcmResolution, int fisResolution) {
+    // inputs of DataFilterNormalizer are sign-normalized into [-1, 1], IT2FIS inputs are in [0, 1]
+    std::array<double, inputDim> lo, hi;
+    lo.fill(-1.0);
+    hi.fill(1.0);
+    std::array<double, fisInputDim> fisLo, fisHi;
+    fisLo.fill(0.0);
+    fisHi.fill(1.0);
+
+    auto gt2fcm = [this](const double* x) { return fuzzyModel.calculate(x); };
+    auto fis = [this](const double* x) { return stableFISExact(x); };
+    gt2fcmTable.build(gt2fcmResolution, lo, hi, gt2fcm);
+    fisTable.build(fisResolution, fisLo, fisHi, fis);
+
+    const auto gt2fcmErr = gt2fcmTable.measureError(gt2fcm, 100000);
+    const auto fisErr = fisTable.measureError(fis, 20000, 20000);
+    compiledErr.gt2fcm = gt2fcmErr.max;
+    compiledErr.gt2fcmMean = gt2fcmErr.mean;
+    compiledErr.probability = std::min(gt2fcmErr.max * 0.5 * std::max(beta_low, beta_high), 1.0);
+    compiledErr.stableFIS = fisErr.max;
+    compiledErr.stableFISMean = fisErr.mean;
+
+    // whole chain, the probability error of the first table feeds the second
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    compiledErr.pipeline = 0;
+    for (int k = 0; k < 20000; k++) {
+        double x[inputDim], exact[fisInputDim], table[fisInputDim];
+        for (int i = 0; i < inputDim; i++) {
+            x[i] = 2.0 * uni(gen) - 1.0;
+        }
+        exact[0] = squash(fuzzyModel.calculate(x));
+        table[0] = squash(gt2fcmTable(x));
+        for (int i = 1; i < fisInputDim; i++) {
+            exact[i] = table[i] = uni(gen);
+        }
+        compiledErr.pipeline = std::max(compiledErr.pipeline, std::abs(fisTable(table) - stableFISExact(exact)));
+    }
+}
+
+void ContactEstimator::decompile() {
+    gt2fcmTable.clear();
+    fisTable.clear();
+    compiledErr = CompiledError();
+}
+
+void ContactEstimator::reset() {
+    const size_t num = endEffectors.size();
+    endEffectors.clear();
+    for (size_t i = 0; i < num; i++) {
+        endEffectors.emplace_back(stableWindow);
+        endEffectors.back().filter.setNormalization(normalization);
+        endEffectors.back().filter.setFilterParams(filterCutoff, filterAccThreshold);
+        endEffectors.back().filter.setNormalizationMode(normMode, normDecayTime, normPercentile);
+        if (!calibrations.empty()) {
+            endEffectors.back().filter.setCalibration(calibrations[i]);
+        }
+    }
+}
+
+void ContactEstimator::step(const ContactSensorFrame* frames) {
+    for (size_t i = 0; i < endEffectors.size(); i++) {
+        stepOne(endEffectors[i], frames[i]);
+    }
+}
+
+void ContactEstimator::step(const std::vector<ContactSensorFrame>& frames) {
+    if (frames.size() != endEffectors.size()) {
+        throw std::invalid_argument("Number of sensor frames does not match number of end-effectors");
+    }
+    step(frames.data());
+}
+
+void ContactEstimator::dataBusRead(const DataBus &robotState) {
+    if (endEffectors.size() != 2) {
+        throw std::logic_error("ContactEstimator bus interface needs exactly two end-effectors");
+    }
+    ContactSensorFrame& fL = busFrames[0];
+    ContactSensorFrame& fR = busFrames[1];
+    for (int i = 0; i < 3; i++) {
+        fL.pos[i] = robotState.fLPos[i];
+        fL.acc[i] = robotState.fLAcc[i];
+        fL.rpy[i] = robotState.fLrpy[i];
+        fL.angular_vel[i] = robotState.fLAngVel[i];
+        fL.linear_vel[i] = robotState.fLLinVel[i];
+        fR.pos[i] = robotState.fRPos[i];
+        fR.acc[i] = robotState.fRAcc[i];
+        fR.rpy[i] = robotState.fRrpy[i];
+        fR.angular_vel[i] = robotState.fRAngVel[i];
+        fR.linear_vel[i] = robotState.fRLinVel[i];
+    }
+    fL.hip_joint_pos = robotState.q(hipJointIdx[0]);
+    fL.knee_joint_pos = robotState.q(kneeJointIdx[0]);
+    fR.hip_joint_pos = robotState.q(hipJointIdx[1]);
+    fR.knee_joint_pos = robotState.q(kneeJointIdx[1]);
+    fL.touch = robotState.fLtouch;
+    fR.touch = robotState.fRtouch;
+    for (int i = 0; i < 4; i++) {
+        fL.corner_touch[i] = robotState.fLcontact[i];
+        fR.corner_touch[i] = robotState.fRcontact[i];
+    }
+}
+
+void ContactEstimator::step() {
+    step(busFrames.data());
+}
+
+void ContactEstimator::dataBusWrite(DataBus &robotState) {
+    const ContactEstimate& estL = endEffectors[0].estimate;
+    const ContactEstimate& estR = endEffectors[1].estimate;
+    robotState.fLcontactEst = estL.is_contact;
+    robotState.fRcontactEst = estR.is_contact;
+    robotState.fLcontactProb = estL.probability;
+    robotState.fRcontactProb = estR.probability;
+    robotState.fLstableContactProb = estL.stable_probability;
+    robotState.fRstableContactProb = estR.stable_probability;
+    robotState.contactEstValid = true;
+}
+
+void ContactEstimator::stepOne(EndEffectorState& state, const ContactSensorFrame& frame) {
+    ContactEstimate& est = state.estimate;
+
+    // filter and normalize GT2FCM inputs
+    state.filter.processData(frame.acc, frame.rpy, frame.linear_vel[2], frame.hip_joint_pos, frame.knee_joint_pos,
+                             est.input_normalized);
+
+    // GT2FCM, then squash around the pivot with different slopes
+    double output = squash(compiled() ? gt2fcmTable(est.input_normalized) : fuzzyModel.calculate(est.input_normalized));
+    est.probability = output;
+    est.is_contact = output > threshold;
+
+    est.contact_truth = frame.touch >= touch_threshold;
+    for (int i = 0; i < 4; i++) {
+        est.corner_contact[i] = frame.corner_touch[i] > 0;
+    }
+
+    // stable contact features
+    state.stable.addFrame(est.is_contact, frame.pos, frame.linear_vel, frame.angular_vel, output);
+    std::array<double, 3> world_vel = state.stable.transformToWorldFrame(frame.linear_vel, frame.rpy);
+    std::array<double, 3> world_ang_vel = state.stable.transformToWorldFrame(frame.angular_vel, frame.rpy);
+
+    est.h_displacement = 0;
+    if (est.is_contact)
+        est.h_displacement = state.stable.calculateHorizontalDisplacement();
+    est.h_velocity = state.stable.calculateHorizontalVelocityMagnitude(world_vel);
+    est.ang_velocity = state.stable.calculateAngularVelocityMagnitude(world_ang_vel);
+
+    est.it2fis_input[0] = std::min(est.h_displacement / max_h_disp, 1.0);
+    est.it2fis_input[1] = std::min(est.h_velocity / max_h_vel, 1.0);
+    est.it2fis_input[2] = std::min(est.ang_velocity / max_ang_vel, 1.0);
+
+    // IT2FIS stable contact probability
+    double it2fis_input[4] = {output, est.it2fis_input[0], est.it2fis_input[1], est.it2fis_input[2]};
+    est.stable_probability = compiled() ? fisTable(it2fis_input) : stableFISExact(it2fis_input);
+}
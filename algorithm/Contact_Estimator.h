@@ -0,0 +1,222 @@
+#ifndef CONTACT_ESTIMATOR_H
+#define CONTACT_ESTIMATOR_H
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+#include "Data_Filter.h"
+#include "GT2FIS_Contact_Fixed.h"
+#include "IT2FIS_Stable_Contact.h"
+#include "IT2FIS_Mamdani.h"
+#include "Multilinear_Table.h"
+#include "data_bus.h"
+
+/**
+ * @brief Sensor sample of one end-effector for one control tick
+ */
+struct ContactSensorFrame {
+    std::array<double, 3> pos{};            // end-effector position, world frame
+    std::array<double, 3> acc{};            // IMU acceleration
+    std::array<double, 3> rpy{};            // roll, pitch, yaw
+    std::array<double, 3> angular_vel{};    // IMU angular velocity
+    std::array<double, 3> linear_vel{};     // linear velocity
+    double hip_joint_pos{0};
+    double knee_joint_pos{0};
+    double touch{0};                        // total touch force, ground truth only
+    std::array<double, 4> corner_touch{};   // toe/heel touch forces (fl, fr, bl, br), ground truth only
+};
+
+/**
+ * @brief Contact estimate of one end-effector for one control tick
+ */
+struct ContactEstimate {
+    std::array<double, 5> input_normalized{}; // GT2FCM input from DataFilterNormalizer
+    double probability{0};                  // squashed GT2FCM output
+    bool is_contact{false};                 // probability > threshold
+    double stable_probability{0};           // IT2FIS stable contact probability
+    double h_displacement{0};               // horizontal displacement while in contact
+    double h_velocity{0};                   // horizontal velocity, world frame
+    double ang_velocity{0};                 // angular velocity magnitude, world frame
+    std::array<double, 3> it2fis_input{};   // normalized h_displacement, h_velocity, ang_velocity
+    bool contact_truth{false};              // touch >= touch_threshold
+    std::array<bool, 4> corner_contact{};   // toe/heel sensors reporting force
+};
+
+/**
+ * @brief Contact estimation for several end-effectors
+ *
+ * Runs DataFilterNormalizer -> GT2FCM -> StableContactDetector -> evaluateMyFIS
+ * (or IT2MamdaniFIS after setStableFIS())
+ * for every end-effector in one pass. Filter histories and stable contact windows
+ * are kept per end-effector, the GT2FCM model is shared since it has no state.
+ * Intended to be called once per control tick.
+ *
+ * With two end-effectors (0: left foot, 1: right foot) it can also follow the
+ * read-compute-write pattern of the other modules: dataBusRead(), step(), dataBusWrite().
+ */
+class ContactEstimator {
+public:
+    static const int numRules = 13;
+    static const int inputDim = 5;
+    static const int fisInputDim = 4;
+
+    /**
+     * @brief Max error of the compiled mode against the exact path
+     *
+     * Measured at the cell centres and at random points, see MultilinearTable::measureError.
+     */
+    struct CompiledError {
+        double gt2fcm{0};       // raw GT2FCM output
+        double gt2fcmMean{0};
+        double probability{0};  // squashed probability, gt2fcm times the steepest tanh slope
+        double stableFIS{0};    // stable contact IT2FIS output for exact inputs
+        double stableFISMean{0};
+        double pipeline{0};     // stable probability through both tables, random inputs
+    };
+
+    // squashing of the GT2FCM output, tanh with different slope below and above the pivot
+    double beta_low{10};
+    double beta_high{12};
+    double pivot{0.65};
+    double threshold{0.75};         // contact decision on the squashed probability
+    double touch_threshold{5};      // ground truth contact force
+    // normalization of the IT2FIS inputs
+    double max_h_disp{0.03};
+    double max_h_vel{1.0};
+    double max_ang_vel{10.0};
+    // joints used as GT2FCM hip/knee inputs, index in DataBus::q, for left and right foot.
+    // left foot uses q(7)/q(18) as the shared memory writer the model was recorded with,
+    // right foot uses the mirrored motors
+    int hipJointIdx[2]{7, 14};
+    int kneeJointIdx[2]{18, 11};
+
+    /**
+     * @brief Constructor, uses the shipped GT2FCM model
+     *
+     * @param numEndEffectors Number of end-effectors estimated per tick
+     * @param stableWindow Window size of the StableContactDetector
+     */
+    explicit ContactEstimator(int numEndEffectors = 2, size_t stableWindow = 100);
+
+    /**
+     * @brief Replace the GT2FCM model
+     */
+    void setModel(const std::vector<std::vector<std::vector<double>>>& ruleBase,
+                  const std::vector<std::vector<double>>& uncertaintyWeights,
+                  int numMF);
+
+    /**
+     * @brief Low-pass cutoff (Hz) and acceleration clipping of every DataFilterNormalizer, kept across reset()
+     */
+    void setFilterParams(double cutoffFreq, double accThreshold);
+
+    /**
+     * @brief Adaptation of the GT2FCM input divisors of every DataFilterNormalizer, kept across reset()
+     *
+     * Drops calibrations set with setCalibration().
+     */
+    void setNormalizationMode(NormalizationMode mode, double decayTime = 5.0, double percentile = 0.99);
+
+    /**
+     * @brief Normalization state of one end-effector, e.g. saved with DataFilterNormalizer::saveCalibration
+     */
+    NormalizerCalibration getCalibration(int idx) const { return endEffectors[idx].filter.getCalibration(); }
+
+    /**
+     * @brief Start one end-effector from a saved normalization state, kept across reset()
+     *
+     * Lets a cold start use the divisors of the previous run's steady state instead of warming up.
+     */
+    void setCalibration(int idx, const NormalizerCalibration& calibration);
+
+    /**
+     * @brief Load a GT2FCM model file, see GT2FCM_ModelFile
+     *
+     * Sets UNR, FCM constant and the input normalization of every end-effector,
+     * calibrations set with setCalibration() are dropped.
+     * The model must have numRules rules and inputDim inputs.
+     *
+     * @param path JSON sidecar or binary model file
+     */
+    void loadModel(const char* path);
+
+    /**
+     * @brief Evaluate the stable contact IT2FIS with IT2MamdaniFIS loaded from a JSON config
+     *
+     * e.g. common/stable_contact_fis.json. Without it the codegen evaluateMyFIS is used.
+     * Throws std::runtime_error on a bad config.
+     */
+    void setStableFIS(const char* jsonPath);
+
+    /**
+     * @brief Switch to the compiled mode
+     *
+     * GT2FCM on [-1, 1]^5 and the stable contact IT2FIS on [0, 1]^4 are tabulated with
+     * the given points per axis and evaluated by multilinear interpolation. The tanh
+     * squashing stays exact, so beta_low/beta_high/pivot/threshold can still be tuned.
+     * Takes up to a few seconds (IT2FIS evaluations of the grid and the error check),
+     * call it before the control loop. setModel(), loadModel() and setStableFIS()
+     * return to the exact path.
+     *
+     * @param gt2fcmResolution Points per axis of the 5-D GT2FCM table
+     * @param fisResolution Points per axis of the 4-D IT2FIS table
+     */
+    void compile(int gt2fcmResolution = 9, int fisResolution = 11);
+    void decompile();
+    bool compiled() const { return !gt2fcmTable.empty(); }
+    const CompiledError& compiledError() const { return compiledErr; }
+    size_t compiledMemoryBytes() const { return gt2fcmTable.memoryBytes() + fisTable.memoryBytes(); }
+
+    /**
+     * @brief Process one tick
+     *
+     * @param frames One sensor frame per end-effector, size()
+     */
+    void step(const ContactSensorFrame* frames);
+    void step(const std::vector<ContactSensorFrame>& frames);
+
+    /**
+     * @brief Bus interface for the biped case, needs size() == 2
+     */
+    void dataBusRead(const DataBus &robotState);
+    void step();   // process the frames read by dataBusRead()
+    void dataBusWrite(DataBus &robotState);
+
+    const ContactEstimate& getEstimate(int idx) const { return endEffectors[idx].estimate; }
+    int size() const { return static_cast<int>(endEffectors.size()); }
+
+    // Reset filter histories and stable contact windows of all end-effectors
+    void reset();
+
+private:
+    struct EndEffectorState {
+        DataFilterNormalizer filter;
+        StableContactDetector stable;
+        ContactEstimate estimate;
+        explicit EndEffectorState(size_t window) : stable(window) {}
+    };
+
+    GT2FCM_Fixed<numRules, inputDim> fuzzyModel;
+    IT2MamdaniFIS stableFIS;
+    std::vector<EndEffectorState> endEffectors;
+    std::vector<ContactSensorFrame> busFrames;
+    size_t stableWindow;
+    std::array<double, inputDim> normalization{1.0, 1.0, 1.0, 1.0, 1.0};
+    double filterCutoff{15.0};
+    double filterAccThreshold{25.0};
+    NormalizationMode normMode{NormalizationMode::RunningMax};
+    double normDecayTime{5.0};
+    double normPercentile{0.99};
+    std::vector<NormalizerCalibration> calibrations;   // per end-effector, empty without setCalibration()
+    // compiled mode, empty tables select the exact path
+    MultilinearTable<inputDim> gt2fcmTable;
+    MultilinearTable<fisInputDim> fisTable;
+    CompiledError compiledErr;
+
+    void stepOne(EndEffectorState& state, const ContactSensorFrame& frame);
+    double squash(double output) const;
+    double stableFISExact(const double* x);
+};
+
+#endif // CONTACT_ESTIMATOR_H
@@ -0,0 +1,62 @@
+#include "Contact_Log.h"
+#include "datalog_reader.h"
+#include <stdexcept>
+
+ContactLog readContactLog(const std::string& logPath, const std::string& scriptPath,
+                          const int* hipJointIdx, const int* kneeJointIdx) {
+    DataLogReader log(logPath, scriptPath);
+    const int feet = log.hasItem("rFtouch") ? 2 : 1;
+    const char* prefix[2] = {"lF", "rF"};
+    const int motorCol = log.itemColumn("motor_pos_cur");
+    const int motorNum = log.itemLength("motor_pos_cur");
+    const int timeCol = log.hasItem("simTime") ? log.itemColumn("simTime") : -1;
+    int posCol[2], rpyCol[2], angVelCol[2], velCol[2], accCol[2], touchCol[2], hipCol[2], kneeCol[2];
+    for (int f = 0; f < feet; f++) {
+        const std::string p = prefix[f];
+        posCol[f] = log.itemColumn(p + "gpsVal");
+        rpyCol[f] = log.itemColumn(p + "rpyVal");
+        angVelCol[f] = log.itemColumn(p + "_AngVel");
+        velCol[f] = log.itemColumn(p + "_vel");
+        accCol[f] = log.itemColumn(p + "_acc");
+        touchCol[f] = log.itemColumn(p + "touch");
+        // DataBus::q holds 7 base coordinates before the motors
+        hipCol[f] = hipJointIdx[f] - 7;
+        kneeCol[f] = kneeJointIdx[f] - 7;
+        if (hipCol[f] < 0 || kneeCol[f] < 0 || hipCol[f] >= motorNum || kneeCol[f] >= motorNum) {
+            throw std::invalid_argument("hip/knee joint index outside motor_pos_cur");
+        }
+        hipCol[f] += motorCol;
+        kneeCol[f] += motorCol;
+    }
+
+    std::vector<double> row(log.columns());
+    ContactLog result;
+    result.feet.resize(feet);
+    double tFirst = 0, tLast = 0;
+    while (log.nextRow(row.data())) {
+        if (timeCol >= 0) {
+            (log.rowsRead() == 1 ? tFirst : tLast) = row[timeCol];
+        }
+        for (int f = 0; f < feet; f++) {
+            ContactSensorFrame fr;
+            for (int i = 0; i < 3; i++) {
+                fr.pos[i] = row[posCol[f] + i];
+                fr.rpy[i] = row[rpyCol[f] + i];
+                fr.angular_vel[i] = row[angVelCol[f] + i];
+                fr.linear_vel[i] = row[velCol[f] + i];
+                fr.acc[i] = row[accCol[f] + i];
+            }
+            fr.hip_joint_pos = row[hipCol[f]];
+            fr.knee_joint_pos = row[kneeCol[f]];
+            fr.touch = row[touchCol[f]];
+            result.feet[f].push_back(fr);
+        }
+    }
+    // logged once per control tick, the mean step of simTime is the tick
+    const size_t rows = log.rowsRead();
+    if (timeCol >= 0 && rows > 1 && tLast > tFirst) {
+        result.dt = (tLast - tFirst) / (rows - 1);
+    }
+    result.skippedLines = log.rowsSkipped();
+    return result;
+}
@@ -0,0 +1,27 @@
+#ifndef CONTACT_LOG_H
+#define CONTACT_LOG_H
+
+#include <vector>
+#include <string>
+
+#include "Contact_Estimator.h"
+
+/**
+ * @brief Sensor frames of a DataLogger log, one sequence per recorded foot
+ */
+struct ContactLog {
+    std::vector<std::vector<ContactSensorFrame>> feet;  // left foot, then right foot if rF* is recorded
+    double dt{0.001};                                   // mean step of simTime, 1 ms without it
+    size_t skippedLines{0};
+};
+
+/**
+ * @brief Read a DataLogger log into ContactSensorFrames, see DataLogReader
+ *
+ * @param scriptPath matlabReadDataScript.txt, empty for the one next to the log
+ * @param hipJointIdx, kneeJointIdx Joints per foot as index in DataBus::q, like ContactEstimator
+ */
+ContactLog readContactLog(const std::string& logPath, const std::string& scriptPath,
+                          const int* hipJointIdx, const int* kneeJointIdx);
+
+#endif // CONTACT_LOG_H
@@ -0,0 +1,217 @@
+#include "Contact_Sweep.h"
+#include "GT2FIS_Default_Model.h"
+#include "GT2FIS_Model_File.h"
+#include "work_stealing_pool.h"
+#include "Contact_Log.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+ContactSweep::ContactSweep()
+    : fuzzyModel(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(),
+                 static_cast<int>(GT2FCM_DefaultRuleBase().size())) {
+}
+
+void ContactSweep::loadModel(const char* path) {
+    GT2FCM_ModelFile model(path);
+    if (model.numRules() != ContactEstimator::numRules || model.inputDim() != ContactEstimator::inputDim) {
+        throw std::invalid_argument("GT2FCM model dimension does not match ContactSweep");
+    }
+    std::copy(model.normalization(), model.normalization() + ContactEstimator::inputDim, normalization.begin());
+    fuzzyModel.setUNR(model.unr(), model.fcmConstant());
+}
+
+void ContactSweep::addSequence(std::vector<ContactSensorFrame> frames, double dt) {
+    if (!(dt > 0.0)) {
+        throw std::invalid_argument("Sequence time step must be positive");
+    }
+    sequences.push_back({std::move(frames), dt});
+}
+
+int ContactSweep::addLog(const std::string& logPath, const std::string& scriptPath,
+                         const int* hipJointIdx, const int* kneeJointIdx) {
+    ContactLog log = readContactLog(logPath, scriptPath, hipJointIdx, kneeJointIdx);
+    for (auto& frames : log.feet) {
+        addSequence(std::move(frames), log.dt);
+    }
+    return static_cast<int>(log.feet.size());
+}
+
+size_t ContactSweep::frameNum() const {
+    size_t n = 0;
+    for (const Sequence& seq : sequences) {
+        n += seq.frames.size();
+    }
+    return n;
+}
+
+// inverse of the squashing in ContactEstimator, both branches meet 0.5 at the pivot
+double ContactSweep::rawThreshold(double betaLow, double betaHigh, double pivot, double threshold) {
+    if (threshold >= 1.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (threshold <= 0.0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    const double beta = threshold >= 0.5 ? betaHigh : betaLow;
+    return pivot + std::atanh(2.0 * threshold - 1.0) / beta;
+}
+
+// same counting as contact_replay: confusion matrix per tick, latency from each truth edge
+// to the first matching estimate while the truth has not changed again
+void ContactSweep::scoreSequence(const Sequence& seq, const double* raw, double rawThr, Score& score) const {
+    bool truth = false;
+    bool waitTouchdown = false, waitLiftoff = false;
+    size_t edge = 0;
+    const double dtMs = seq.dt * 1e3;
+    for (size_t k = 0; k < seq.frames.size(); k++) {
+        const bool truthNow = seq.frames[k].touch >= touch_threshold;
+        const bool estNow = raw[k] > rawThr;
+        if (truthNow) {
+            estNow ? score.tp++ : score.fn++;
+        } else {
+            estNow ? score.fp++ : score.tn++;
+        }
+
+        if (truthNow && !truth) {
+            score.touchdowns++;
+            edge = k;
+            waitTouchdown = true;
+            waitLiftoff = false;
+        } else if (!truthNow && truth) {
+            if (waitTouchdown) {
+                score.missedTouchdowns++;
+            }
+            waitTouchdown = false;
+            edge = k;
+            waitLiftoff = true;
+        }
+        if (waitTouchdown && estNow) {
+            score.touchdownDelaySum += (k - edge) * dtMs;
+            score.touchdownDelayNum++;
+            waitTouchdown = false;
+        }
+        if (waitLiftoff && !estNow) {
+            score.liftoffDelaySum += (k - edge) * dtMs;
+            score.liftoffDelayNum++;
+            waitLiftoff = false;
+        }
+        truth = truthNow;
+    }
+}
+
+std::vector<ContactSweepResult> ContactSweep::run(const ContactSweepGrid& grid, unsigned threads) {
+    if (grid.size() == 0) {
+        return {};
+    }
+    WorkStealingPool pool(threads);
+
+    // phase 1: filter + GT2FCM output for every filter setting and sequence
+    struct FilterSetting {
+        double cutoffFreq, accThreshold;
+    };
+    std::vector<FilterSetting> filters;
+    for (double fc : grid.cutoffFreq) {
+        for (double acc : grid.accThreshold) {
+            filters.push_back({fc, acc});
+            DataFilterNormalizer().setFilterParams(fc, acc);   // reject bad settings before starting
+        }
+    }
+    const size_t seqNum = sequences.size();
+    std::vector<std::vector<double>> raw(filters.size() * seqNum);
+    std::vector<GT2FCM_Fixed<ContactEstimator::numRules, ContactEstimator::inputDim>> models(pool.size(), fuzzyModel);
+    pool.parallelFor(raw.size(), [&](size_t task, unsigned worker) {
+        const FilterSetting& fs = filters[task / seqNum];
+        const Sequence& seq = sequences[task % seqNum];
+        DataFilterNormalizer filter;
+        filter.setNormalization(normalization);
+        filter.setFilterParams(fs.cutoffFreq, fs.accThreshold);
+        std::vector<double>& out = raw[task];
+        out.resize(seq.frames.size());
+        std::array<double, 5> input;
+        for (size_t k = 0; k < seq.frames.size(); k++) {
+            const ContactSensorFrame& f = seq.frames[k];
+            filter.processData(f.acc, f.rpy, f.linear_vel[2], f.hip_joint_pos, f.knee_joint_pos, input);
+            out[k] = models[worker].calculate(input.data());
+        }
+    });
+    lastStolen = pool.stolen();
+
+    // phase 2: score the distinct raw thresholds, chunks of them per filter setting
+    std::vector<double> thresholds;
+    for (double bl : grid.betaLow) {
+        for (double bh : grid.betaHigh) {
+            for (double p : grid.pivot) {
+                for (double t : grid.threshold) {
+                    thresholds.push_back(rawThreshold(bl, bh, p, t));
+                }
+            }
+        }
+    }
+    std::vector<double> distinct(thresholds);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+    const size_t chunk = 16;
+    const size_t chunkNum = (distinct.size() + chunk - 1) / chunk;
+    std::vector<Score> scores(filters.size() * distinct.size());
+    pool.parallelFor(filters.size() * chunkNum, [&](size_t task, unsigned) {
+        const size_t fi = task / chunkNum;
+        const size_t begin = (task % chunkNum) * chunk;
+        const size_t end = std::min(begin + chunk, distinct.size());
+        for (size_t u = begin; u < end; u++) {
+            Score& score = scores[fi * distinct.size() + u];
+            for (size_t s = 0; s < seqNum; s++) {
+                scoreSequence(sequences[s], raw[fi * seqNum + s].data(), distinct[u], score);
+            }
+        }
+    });
+    lastStolen += pool.stolen();
+    lastFilterRuns = raw.size();
+    lastDistinctThresholds = distinct.size();
+
+    // expand to the full grid
+    std::vector<ContactSweepResult> results;
+    results.reserve(grid.size());
+    for (size_t fi = 0; fi < filters.size(); fi++) {
+        size_t ti = 0;
+        for (double bl : grid.betaLow) {
+            for (double bh : grid.betaHigh) {
+                for (double p : grid.pivot) {
+                    for (double t : grid.threshold) {
+                        const double rawThr = thresholds[ti++];
+                        const size_t u = std::lower_bound(distinct.begin(), distinct.end(), rawThr) - distinct.begin();
+                        const Score& sc = scores[fi * distinct.size() + u];
+                        ContactSweepResult r;
+                        r.cutoffFreq = filters[fi].cutoffFreq;
+                        r.accThreshold = filters[fi].accThreshold;
+                        r.betaLow = bl;
+                        r.betaHigh = bh;
+                        r.pivot = p;
+                        r.threshold = t;
+                        r.rawThreshold = rawThr;
+                        r.tp = sc.tp;
+                        r.fp = sc.fp;
+                        r.fn = sc.fn;
+                        r.tn = sc.tn;
+                        r.touchdowns = sc.touchdowns;
+                        r.missedTouchdowns = sc.missedTouchdowns;
+                        r.touchdownDelay = sc.touchdownDelayNum ? sc.touchdownDelaySum / sc.touchdownDelayNum : 0.0;
+                        r.liftoffDelay = sc.liftoffDelayNum ? sc.liftoffDelaySum / sc.liftoffDelayNum : 0.0;
+                        results.push_back(r);
+                    }
+                }
+            }
+        }
+    }
+    return results;
+}
+
+void ContactSweep::rank(std::vector<ContactSweepResult>& results) {
+    std::stable_sort(results.begin(), results.end(), [](const ContactSweepResult& a, const ContactSweepResult& b) {
+        if (a.f1() != b.f1()) return a.f1() > b.f1();
+        if (a.touchdownDelay != b.touchdownDelay) return a.touchdownDelay < b.touchdownDelay;
+        return a.liftoffDelay < b.liftoffDelay;
+    });
+}
@@ -0,0 +1,141 @@
+#ifndef CONTACT_SWEEP_H
+#define CONTACT_SWEEP_H
+
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <string>
+
+#include "Contact_Estimator.h"
+
+/**
+ * @brief Parameter grid of a contact detection sweep, every combination is evaluated
+ */
+struct ContactSweepGrid {
+    std::vector<double> cutoffFreq{15.0};       // DataFilterNormalizer low-pass cutoff, Hz
+    std::vector<double> accThreshold{25.0};     // DataFilterNormalizer acceleration clipping
+    std::vector<double> betaLow{10.0};
+    std::vector<double> betaHigh{12.0};
+    std::vector<double> pivot{0.65};
+    std::vector<double> threshold{0.75};
+
+    size_t size() const {
+        return cutoffFreq.size() * accThreshold.size() * betaLow.size() * betaHigh.size() *
+               pivot.size() * threshold.size();
+    }
+};
+
+/**
+ * @brief Score of one parameter combination over all sequences
+ */
+struct ContactSweepResult {
+    double cutoffFreq{0}, accThreshold{0};
+    double betaLow{0}, betaHigh{0}, pivot{0}, threshold{0};
+    double rawThreshold{0};             // equivalent threshold on the GT2FCM output before squashing
+    size_t tp{0}, fp{0}, fn{0}, tn{0};
+    size_t touchdowns{0}, missedTouchdowns{0};
+    double touchdownDelay{0};           // mean ms from truth rising to is_contact rising
+    double liftoffDelay{0};             // mean ms from truth falling to is_contact falling
+
+    double precision() const { return (tp + fp) ? double(tp) / (tp + fp) : 0.0; }
+    double recall() const { return (tp + fn) ? double(tp) / (tp + fn) : 0.0; }
+    double f1() const { return (2 * tp + fp + fn) ? 2.0 * tp / (2 * tp + fp + fn) : 0.0; }
+};
+
+/**
+ * @brief Offline sweep of the contact detection parameters over recorded sequences
+ *
+ * Sequences (one end-effector each, e.g. loaded with DataLogReader) are kept in
+ * memory and replayed from a fresh filter state for every filter setting.
+ * Ground truth is touch >= touch_threshold, scores are those of ContactEstimator::is_contact.
+ *
+ * The squashing is increasing, so probability > threshold is the same as
+ * GT2FCM output > rawThreshold, with rawThreshold = pivot + atanh(2 threshold - 1) / beta
+ * (beta_high for threshold >= 0.5, beta_low below). The sweep therefore runs
+ * DataFilterNormalizer + GT2FCM once per (cutoffFreq, accThreshold) and sequence,
+ * then scores every distinct rawThreshold on the stored outputs. Combinations
+ * with the same rawThreshold get the same score.
+ *
+ * Both phases run on a WorkStealingPool. Every task builds its own
+ * DataFilterNormalizer and copies the GT2FCM model, nothing mutable is shared.
+ */
+class ContactSweep {
+public:
+    double touch_threshold{5};
+
+    ContactSweep();
+
+    /**
+     * @brief Replace the GT2FCM model used for all combinations, see ContactEstimator::loadModel
+     */
+    void loadModel(const char* path);
+
+    /**
+     * @brief Add one recorded sequence of one end-effector
+     *
+     * @param frames Sensor frames in time order, touch is the ground truth
+     * @param dt Time between frames, s
+     */
+    void addSequence(std::vector<ContactSensorFrame> frames, double dt = 0.001);
+
+    /**
+     * @brief Add the left (and, if recorded, right) foot of a DataLogger log, see DataLogReader
+     *
+     * @param hipJointIdx, kneeJointIdx Joints per foot as index in DataBus::q, like ContactEstimator
+     * @return Number of sequences added
+     */
+    int addLog(const std::string& logPath, const std::string& scriptPath,
+               const int* hipJointIdx, const int* kneeJointIdx);
+
+    size_t sequenceNum() const { return sequences.size(); }
+    const std::vector<ContactSensorFrame>& sequence(size_t idx) const { return sequences[idx].frames; }
+    size_t frameNum() const;
+
+    /**
+     * @brief Evaluate every combination of the grid
+     *
+     * @param threads Worker threads, 0 uses all hardware threads
+     * @return One result per combination, in grid order (threshold varies fastest)
+     */
+    std::vector<ContactSweepResult> run(const ContactSweepGrid& grid, unsigned threads = 0);
+
+    /**
+     * @brief Sort by F1 (descending), ties by touchdown delay then liftoff delay
+     */
+    static void rank(std::vector<ContactSweepResult>& results);
+
+    /**
+     * @brief Threshold on the GT2FCM output equivalent to probability > threshold
+     */
+    static double rawThreshold(double betaLow, double betaHigh, double pivot, double threshold);
+
+    // statistics of the last run
+    size_t filterRuns() const { return lastFilterRuns; }
+    size_t distinctThresholds() const { return lastDistinctThresholds; }
+    size_t stolenTasks() const { return lastStolen; }
+
+private:
+    struct Sequence {
+        std::vector<ContactSensorFrame> frames;
+        double dt;
+    };
+
+    // accumulated score of one raw threshold
+    struct Score {
+        size_t tp{0}, fp{0}, fn{0}, tn{0};
+        size_t touchdowns{0}, missedTouchdowns{0};
+        double touchdownDelaySum{0}, liftoffDelaySum{0};
+        size_t touchdownDelayNum{0}, liftoffDelayNum{0};
+    };
+
+    GT2FCM_Fixed<ContactEstimator::numRules, ContactEstimator::inputDim> fuzzyModel;
+    std::array<double, ContactEstimator::inputDim> normalization{1.0, 1.0, 1.0, 1.0, 1.0};
+    std::vector<Sequence> sequences;
+    size_t lastFilterRuns{0};
+    size_t lastDistinctThresholds{0};
+    size_t lastStolen{0};
+
+    void scoreSequence(const Sequence& seq, const double* raw, double rawThr, Score& score) const;
+};
+
+#endif // CONTACT_SWEEP_H
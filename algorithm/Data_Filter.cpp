@@ -1,7 +1,12 @@
 #include "Data_Filter.h"
+#include "json/json.h"
+#include <fstream>
 #include <numeric>
 #include <cmath>
 #include <algorithm>
+#include <stdexcept>
+
+const std::array<double, 5> DataFilterNormalizer::recordedMaxima = {21.3960, 1.4480, 0.6092, 1.2164, 497.9108};
 
 DataFilterNormalizer::DataFilterNormalizer() {
     // Initialize filter coefficients
@@ -12,7 +17,10 @@ DataFilterNormalizer::DataFilterNormalizer() {
 void DataFilterNormalizer::initialize() {
 
     // Initialize histories with appropriate size and zeros
-    lF_acc_history.clear();
+    lF_acc_lpf.reset();
+    lF_acc_x_history.clear();
+    lF_acc_y_history.clear();
+    lF_acc_z_history.clear();
     lF_acc_vertical_history.clear();
     lF_accz_diff_history.clear();
     lF_vel_z_history.clear();
@@ -21,140 +29,234 @@ void DataFilterNormalizer::initialize() {
     
     // Fill histories with zeros for initial state
     for (int i = 0; i < std::max(window_size, 3*order); i++) {
-        lF_acc_history.push_back({0.0, 0.0, 0.0});
         lF_acc_vertical_history.push_back(0.0);
-        lF_accz_diff_history.push_back(0.0);
-        lF_vel_z_history.push_back(0.0);
-        hip_joint_pos_history.push_back(0.0);
-        knee_joint_pos_history.push_back(0.0);
+        lF_accz_diff_history.add(0.0);
+        lF_vel_z_history.add(0.0);
+        hip_joint_pos_history.add(0.0);
+        knee_joint_pos_history.add(0.0);
     }
     
-    // Reset max values for normalization
-    max_lF_acc_vertical = 1.0;
-    max_lF_vel_z = 1.0;
-    max_hip_joint_pos = 1.0;
-    max_knee_joint_pos = 1.0;
-    max_lF_accz_diff = 1.0;
+    // Restore the normalization divisors and percentile sketches
+    scale = start_scale;
+    for (size_t i = 0; i < abs_quantile.size(); i++) {
+        abs_quantile[i] = P2Quantile(norm_percentile);
+        if (start_quantile[i].count > 0) {
+            abs_quantile[i].restore(start_quantile[i]);
+        }
+    }
     
     // Reset previous values
     prev_lF_acc_vertical = {0.0, 0.0, 0.0};
     prev_lF_accz = 0.0;
-    
-    lF_acc_output_history.clear();
-    for (int i = 0; i < 3*order; i++) {
-        lF_acc_output_history.push_back({0.0, 0.0, 0.0});
-    }
+
 }
 
 void DataFilterNormalizer::reset() {
     initialize();
 }
 
-/* Design Butterworth low-pass filter coefficients
-    * This is a simplified implementation based on common filter coefficients
-    * For a more accurate implementation, additional digital filter design libraries may be needed
-    */
+void DataFilterNormalizer::setFilterParams(double cutoffFreq, double accThreshold) {
+    if (!(cutoffFreq > 0.0 && cutoffFreq < 0.5 * fs) || !(accThreshold > 0.0)) {
+        throw std::invalid_argument("Cutoff frequency must be in (0, fs/2) and acceleration threshold positive");
+    }
+    cutoff_freq = cutoffFreq;
+    acc_threshold = accThreshold;
+    designButterLowPass();
+}
 
-void DataFilterNormalizer::designButterLowPass() {
-    // Design 2nd-order Butterworth low-pass filter
-    // This is a simplified implementation based on common filter coefficients
-    // For a more accurate implementation, additional digital filter design libraries may be needed
-    
-    double Wn = 2.0 * cutoff_freq / fs;  // Normalized cutoff frequency
-    
-    // For a 2nd-order Butterworth low-pass filter:
-    // These are pre-calculated coefficients for a normalized cutoff of Wn
-    double ita = tan(M_PI * Wn / 2.0);
-    double q = sqrt(2.0);
-    
-    // Filter coefficients calculation
-    double b0 = ita * ita / (1 + q * ita + ita * ita);
-    double b1 = 2 * b0;
-    double b2 = b0;
-    double a1 = 2 * (ita * ita - 1) / (1 + q * ita + ita * ita);
-    double a2 = (1 - q * ita + ita * ita) / (1 + q * ita + ita * ita);
-    
-    // Store coefficients
-    b = {b0, b1, b2};
-    a = {1.0, a1, a2};  // a0 is assumed to be 1
+void DataFilterNormalizer::setNormalization(const std::array<double, 5>& divisors) {
+    for (double v : divisors) {
+        if (v == 0.0) {
+            throw std::invalid_argument("Normalization divisor must be nonzero");
+        }
+    }
+    normalization = divisors;
+    setNormalizationMode(norm_mode, norm_decay_time, norm_percentile);
 }
 
-/*  Apply median filter to a value using history
-    * This function applies a median filter to the input value using the history of previous values
-    * The history is maintained as a deque for efficient insertion and removal
-    */
-double DataFilterNormalizer::applyMedianFilter(double value, std::deque<double>& history) {
-    // Add new value to history
-    history.push_back(value);
-    if (history.size() > window_size) {
-        history.pop_front();
+void DataFilterNormalizer::setNormalizationMode(NormalizationMode mode, double decayTime, double percentile) {
+    if (!(decayTime > 0.0) || !(percentile > 0.0 && percentile < 1.0)) {
+        throw std::invalid_argument("Decay time must be positive and percentile in (0, 1)");
     }
-    
-    // Copy values for sorting
-    std::vector<double> values(history.begin(), history.end());
-    std::sort(values.begin(), values.end());
-    
-    // Return median value
-    if (values.size() % 2 == 0) {
-        return (values[values.size()/2 - 1] + values[values.size()/2]) / 2.0;
-    } else {
-        return values[values.size()/2];
+    norm_mode = mode;
+    norm_decay_time = decayTime;
+    norm_decay = std::exp(-dt / decayTime);
+    norm_percentile = percentile;
+    start_scale = normalization;
+    start_quantile = {};
+    scale = start_scale;
+    for (P2Quantile& q : abs_quantile) {
+        q = P2Quantile(percentile);
     }
 }
 
-std::array<double, 3> DataFilterNormalizer::applyButterworthFilter(
-    const std::array<double, 3>& input, 
-    std::deque<std::array<double, 3>>& history) {
-    
-    // Add new input to history
-    history.push_back(input);
-    if (history.size() > 3*order) {
-        history.pop_front();
+NormalizerCalibration DataFilterNormalizer::getCalibration() const {
+    NormalizerCalibration cal;
+    cal.mode = norm_mode;
+    cal.decayTime = norm_decay_time;
+    cal.percentile = norm_percentile;
+    cal.scale = scale;
+    for (size_t i = 0; i < abs_quantile.size(); i++) {
+        if (norm_mode == NormalizationMode::Percentile) {
+            cal.quantiles[i] = abs_quantile[i].state();
+        }
     }
-    
-    // Apply filter to each axis
-    std::array<double, 3> output = {0.0, 0.0, 0.0};
-    
-    if (history.size() >= 3) {  // Need at least 3 samples for 2nd order filter
-        for (int axis = 0; axis < 3; axis++) { 
-            // Apply filter formula: y[n] = b0*x[n] + b1*x[n-1] + b2*x[n-2] - a1*y[n-1] - a2*y[n-2]
-            size_t h_size = history.size();
-            
-            // Input components
-            double x0 = history[h_size-1][axis];
-            double x1 = history[h_size-2][axis];
-            double x2 = history[h_size-3][axis];
-            
-            // Previous output components
-            // For simplicity, we're getting these from the history directly
-            // In a more advanced implementation, we would maintain separate output history
-            // 前一个输出分量 - 使用输出历史而非输入历史
-            double y1 = lF_acc_output_history[lF_acc_output_history.size()-1][axis];
-            double y2 = lF_acc_output_history[lF_acc_output_history.size()-2][axis];
-            
-            // Calculate output
-            output[axis] = b[0]*x0 + b[1]*x1 + b[2]*x2 - a[1]*y1 - a[2]*y2;
+    return cal;
+}
+
+void DataFilterNormalizer::setCalibration(const NormalizerCalibration& calibration) {
+    for (double v : calibration.scale) {
+        if (!(v > 0.0)) {
+            throw std::invalid_argument("Calibrated divisor must be positive");
+        }
+    }
+    for (const P2Quantile::State& q : calibration.quantiles) {
+        if (q.count > 0 && q.p != calibration.percentile) {
+            throw std::invalid_argument("Calibration sketch does not match its percentile");
+        }
+    }
+    setNormalizationMode(calibration.mode, calibration.decayTime, calibration.percentile);
+    start_scale = calibration.scale;
+    start_quantile = calibration.quantiles;
+    scale = start_scale;
+    for (size_t i = 0; i < abs_quantile.size(); i++) {
+        if (start_quantile[i].count > 0) {
+            abs_quantile[i].restore(start_quantile[i]);
+        }
+    }
+}
+
+static const char* modeName(NormalizationMode mode) {
+    switch (mode) {
+        case NormalizationMode::Fixed: return "fixed";
+        case NormalizationMode::DecayingMax: return "decaying_max";
+        case NormalizationMode::Percentile: return "percentile";
+        default: return "running_max";
+    }
+}
+
+void DataFilterNormalizer::saveCalibration(const char* path, const NormalizerCalibration& calibration) {
+    Json::Value root;
+    root["mode"] = modeName(calibration.mode);
+    root["decayTime"] = calibration.decayTime;
+    root["percentile"] = calibration.percentile;
+    root["scale"] = Json::Value(Json::arrayValue);
+    root["quantiles"] = Json::Value(Json::arrayValue);
+    for (size_t i = 0; i < calibration.scale.size(); i++) {
+        root["scale"].append(calibration.scale[i]);
+        const P2Quantile::State& q = calibration.quantiles[i];
+        Json::Value sketch;
+        sketch["count"] = Json::UInt64(q.count);
+        sketch["height"] = Json::Value(Json::arrayValue);
+        sketch["position"] = Json::Value(Json::arrayValue);
+        sketch["desired"] = Json::Value(Json::arrayValue);
+        for (int k = 0; k < 5; k++) {
+            sketch["height"].append(q.height[k]);
+            sketch["position"].append(q.position[k]);
+            sketch["desired"].append(q.desired[k]);
+        }
+        root["quantiles"].append(sketch);
+    }
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error(std::string("Cannot write normalizer calibration ") + path);
+    }
+    file << Json::StyledWriter().write(root);
+    if (!file) {
+        throw std::runtime_error(std::string("Cannot write normalizer calibration ") + path);
+    }
+}
+
+NormalizerCalibration DataFilterNormalizer::loadCalibration(const char* path) {
+    std::ifstream file(path);
+    Json::Reader reader;
+    Json::Value root;
+    if (!file || !reader.parse(file, root)) {
+        throw std::runtime_error(std::string("Cannot read normalizer calibration ") + path);
+    }
+    NormalizerCalibration cal;
+    const std::string mode = root["mode"].asString();
+    for (NormalizationMode m : {NormalizationMode::RunningMax, NormalizationMode::Fixed,
+                                NormalizationMode::DecayingMax, NormalizationMode::Percentile}) {
+        if (mode == modeName(m)) {
+            cal.mode = m;
         }
-    } else {
-        // Not enough history, return the input
-        output = input;
     }
-    // 保存输出到历史
-    lF_acc_output_history.push_back(output);
-    if (lF_acc_output_history.size() > 3*order) {
-        lF_acc_output_history.pop_front();
+    if (mode != modeName(cal.mode)) {
+        throw std::runtime_error("Unknown normalization mode " + mode + " in " + path);
+    }
+    cal.decayTime = root.get("decayTime", cal.decayTime).asDouble();
+    cal.percentile = root.get("percentile", cal.percentile).asDouble();
+    const Json::Value& scale = root["scale"];
+    const Json::Value& quantiles = root["quantiles"];
+    if (scale.size() != cal.scale.size() || (!quantiles.isNull() && quantiles.size() != cal.quantiles.size())) {
+        throw std::runtime_error(std::string("Normalizer calibration needs 5 channels: ") + path);
     }
+    for (Json::ArrayIndex i = 0; i < scale.size(); i++) {
+        cal.scale[i] = scale[i].asDouble();
+        if (quantiles.isNull()) {
+            continue;
+        }
+        P2Quantile::State& q = cal.quantiles[i];
+        q.p = cal.percentile;
+        q.count = quantiles[i]["count"].asUInt64();
+        for (Json::ArrayIndex k = 0; k < 5 && q.count > 0; k++) {
+            q.height[k] = quantiles[i]["height"][k].asDouble();
+            q.position[k] = quantiles[i]["position"][k].asDouble();
+            q.desired[k] = quantiles[i]["desired"][k].asDouble();
+        }
+    }
+    return cal;
+}
+
+/* Design Butterworth low-pass filter coefficients
+    * order, cutoff_freq and fs give the second-order sections of the cascade
+    */
+void DataFilterNormalizer::designButterLowPass() {
+    lF_acc_lpf = BiquadBank(3, BiquadBank::butterworthLowPass(order, cutoff_freq, fs));
+}
+
+/*  Apply median filter to a value using history
+    * The window is kept by StreamingMedian (two heaps over a ring of window_size samples),
+    * the result is the same as sorting the window, without copying or sorting it per sample
+    */
+double DataFilterNormalizer::applyMedianFilter(double value, StreamingMedian& history) {
+    return history.add(value);
+}
+
+std::array<double, 3> DataFilterNormalizer::applyButterworthFilter(const std::array<double, 3>& input) {
+    // Direct Form II Transposed, states start at zero like the zero-filled histories before
+    std::array<double, 3> output;
+    lF_acc_lpf.process(input.data(), output.data());
     return output;
 }
 
-double DataFilterNormalizer::normalizeWithSign(double value, double max_value) {
-    // Update max value if needed
-    if (std::abs(value) > max_value) {
-        max_value = std::abs(value);
+double DataFilterNormalizer::normalizeWithSign(double value, int idx) {
+    const double magnitude = std::abs(value);
+    double& divisor = scale[idx];
+    switch (norm_mode) {
+        case NormalizationMode::RunningMax:
+            // grows with the largest value so far, the output stays in [-1, 1] without clipping
+            if (magnitude > divisor) {
+                divisor = magnitude;
+            }
+            return value / divisor;
+        case NormalizationMode::Fixed:
+            return std::min(std::max(value / divisor, -1.0), 1.0);
+        case NormalizationMode::DecayingMax: {
+            const double floor = normalization[idx];
+            divisor = std::max(magnitude, floor + (divisor - floor) * norm_decay);
+            return value / divisor;
+        }
+        case NormalizationMode::Percentile:
+            // start divisor until the sketch has its five markers
+            abs_quantile[idx].add(magnitude);
+            if (abs_quantile[idx].count() >= 5) {
+                divisor = std::max(abs_quantile[idx].value(), 1e-9);
+            }
+            return std::min(std::max(value / divisor, -1.0), 1.0);
     }
-    
-    // Sign-preserving normalization
-    return (value / max_value);
+    return value / divisor;
 }
 
 std::vector<double> DataFilterNormalizer::processData(
@@ -163,6 +265,18 @@ std::vector<double> DataFilterNormalizer::processData(
     double lF_vel_z,
     double hip_joint_pos,
     double knee_joint_pos) {
+    std::array<double, 5> out;
+    processData(lF_acc, lF_rpy, lF_vel_z, hip_joint_pos, knee_joint_pos, out);
+    return std::vector<double>(out.begin(), out.end());
+}
+
+void DataFilterNormalizer::processData(
+    const std::array<double, 3>& lF_acc,
+    const std::array<double, 3>& lF_rpy,
+    double lF_vel_z,
+    double hip_joint_pos,
+    double knee_joint_pos,
+    std::array<double, 5>& out) {
     
     // Step 1: Apply threshold to acceleration data
     std::array<double, 3> lF_acc_thresholded = {
@@ -172,15 +286,15 @@ std::vector<double> DataFilterNormalizer::processData(
     }; 
     
     // Step 2: Apply median filter
-    // For simplicity, we'll only apply median filter to z-component
-    // In a more comprehensive implementation, we would apply to all axes
-    // lF_acc_thresholded[0] = applyMedianFilter(lF_acc_thresholded[0], lF_acc_x_history);
-    // lF_acc_thresholded[1] = applyMedianFilter(lF_acc_thresholded[1], lF_acc_y_history);
-    // lF_acc_thresholded[2] = applyMedianFilter(lF_acc_thresholded[2], lF_acc_z_history);
+    if (median_filter_acc) {
+        lF_acc_thresholded[0] = applyMedianFilter(lF_acc_thresholded[0], lF_acc_x_history);
+        lF_acc_thresholded[1] = applyMedianFilter(lF_acc_thresholded[1], lF_acc_y_history);
+        lF_acc_thresholded[2] = applyMedianFilter(lF_acc_thresholded[2], lF_acc_z_history);
+    }
 
     
     // Step 3: Apply Butterworth low-pass filter
-    lF_acc_filtered = applyButterworthFilter(lF_acc_thresholded, lF_acc_history);
+    lF_acc_filtered = applyButterworthFilter(lF_acc_thresholded);
     
     // Step 4: Transform accelerations to world frame using rotation matrices
     // Convert angles from degrees to radians if needed
@@ -225,51 +339,23 @@ std::vector<double> DataFilterNormalizer::processData(
     double lF_accz_diff = (lF_acc_world[2] - prev_lF_accz) / dt;
     prev_lF_accz = lF_acc_world[2];
     
-    // Store in history for future filtering
-    lF_accz_diff_history.push_back(lF_accz_diff);
-    if (lF_accz_diff_history.size() > window_size) {
-        lF_accz_diff_history.pop_front();
-    }
-    
-    // Also store velocity and joint positions in history
-    lF_vel_z_history.push_back(lF_vel_z);
-    hip_joint_pos_history.push_back(hip_joint_pos);
-    knee_joint_pos_history.push_back(knee_joint_pos);
-    
-    if (lF_vel_z_history.size() > window_size) lF_vel_z_history.pop_front();
-    if (hip_joint_pos_history.size() > window_size) hip_joint_pos_history.pop_front();
-    if (knee_joint_pos_history.size() > window_size) knee_joint_pos_history.pop_front();
-    
-    //Step 6: Update max values for normalization
-    if (std::abs(lF_acc_world[2]) > max_lF_acc_vertical) {
-        max_lF_acc_vertical = std::abs(lF_acc_world[2]);
-    }
-    
-    if (std::abs(lF_vel_z) > max_lF_vel_z) {
-        max_lF_vel_z = std::abs(lF_vel_z);
-    }
-    
-    if (std::abs(hip_joint_pos) > max_hip_joint_pos) {
-        max_hip_joint_pos = std::abs(hip_joint_pos);
-    }
-    
-    if (std::abs(knee_joint_pos) > max_knee_joint_pos) {
-        max_knee_joint_pos = std::abs(knee_joint_pos);
-    }
-    
-    if (std::abs(lF_accz_diff) > max_lF_accz_diff) {
-        max_lF_accz_diff = std::abs(lF_accz_diff);
+    // Median filter on the remaining inputs
+    if (median_filter_inputs) {
+        lF_accz_diff = applyMedianFilter(lF_accz_diff, lF_accz_diff_history);
+        lF_vel_z = applyMedianFilter(lF_vel_z, lF_vel_z_history);
+        hip_joint_pos = applyMedianFilter(hip_joint_pos, hip_joint_pos_history);
+        knee_joint_pos = applyMedianFilter(knee_joint_pos, knee_joint_pos_history);
     }
     
-    // Step 7: Calculate normalized values
-    double lF_accz_normalized = normalizeWithSign(lF_acc_world[2], max_lF_acc_vertical);
-    double lF_velz_normalized = normalizeWithSign(lF_vel_z, max_lF_vel_z);
-    double hip_joint_normalized = normalizeWithSign(hip_joint_pos, max_hip_joint_pos);
-    double knee_joint_normalized = normalizeWithSign(knee_joint_pos, max_knee_joint_pos);
-    double lF_accz_diff_normalized = normalizeWithSign(lF_accz_diff, max_lF_accz_diff);
+    // Step 6: Update the divisors and calculate normalized values
+    double lF_accz_normalized = normalizeWithSign(lF_acc_world[2], 0);
+    double lF_velz_normalized = normalizeWithSign(lF_vel_z, 1);
+    double hip_joint_normalized = normalizeWithSign(hip_joint_pos, 2);
+    double knee_joint_normalized = normalizeWithSign(knee_joint_pos, 3);
+    double lF_accz_diff_normalized = normalizeWithSign(lF_accz_diff, 4);
     
-    //Return the five normalized values
-    return {
+    // The five normalized values
+    out = {
         lF_accz_normalized,
         lF_velz_normalized,
         hip_joint_normalized,
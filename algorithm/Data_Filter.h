@@ -7,38 +7,63 @@
 #include <algorithm>
 #include <array>
 
+#include "Sliding_Window.h"
+#include "biquad_bank.h"
+
+// How the normalization divisor of every output follows the data
+enum class NormalizationMode {
+    RunningMax,     // divisor = max(start divisor, largest |value| so far), grows only
+    Fixed,          // divisor = normalization divisor, outputs clipped to [-1, 1]
+    DecayingMax,    // jumps to a larger |value|, relaxes back to the normalization divisor with decayTime
+    Percentile      // divisor = running percentile of |value| (P2Quantile), outputs clipped to [-1, 1]
+};
+
+// Normalization state of a DataFilterNormalizer, can be saved after a run and restored
+// before the next one so that it starts from the adapted divisors instead of a warm-up
+struct NormalizerCalibration {
+    NormalizationMode mode{NormalizationMode::RunningMax};
+    double decayTime{5.0};                          // s, DecayingMax
+    double percentile{0.99};                        // Percentile
+    std::array<double, 5> scale{1.0, 1.0, 1.0, 1.0, 1.0};  // current divisors in processData order
+    std::array<P2Quantile::State, 5> quantiles{};          // Percentile sketches, count 0 when unused
+};
+
 class DataFilterNormalizer {
 private:
     // Constants
     const double g = 9.81;           // gravitational acceleration in m/s^2
     const double fs = 1000.0;        // sampling frequency in Hz
     const double dt = 0.001;         // time step
-    const double acc_threshold = 25.0; // acceleration threshold
+    double acc_threshold = 25.0;     // acceleration threshold
     const int window_size = 5;       // median filter window size
-    const double cutoff_freq = 15.0; // cutoff frequency for low-pass filter
+    double cutoff_freq = 15.0;       // cutoff frequency for low-pass filter
     const int order = 2;             // filter order
 
-    // Filter coefficients
-    std::vector<double> b;  // numerator coefficients
-    std::vector<double> a;  // denominator coefficients
+    // Butterworth low-pass of the acceleration x/y/z, one channel per axis
+    BiquadBank lF_acc_lpf;
 
     // State variables for filtering
-    std::deque<std::array<double, 3>> lF_acc_history;  // Left foot acceleration history
-    std::deque<double> lF_acc_x_history;
-    std::deque<double> lF_acc_y_history;
-    std::deque<double> lF_acc_z_history;
+    StreamingMedian lF_acc_x_history{static_cast<size_t>(window_size)};
+    StreamingMedian lF_acc_y_history{static_cast<size_t>(window_size)};
+    StreamingMedian lF_acc_z_history{static_cast<size_t>(window_size)};
     std::deque<double> lF_acc_vertical_history;        // Left foot vertical acceleration history
-    std::deque<double> lF_accz_diff_history;           // Left foot vertical acceleration derivative history
-    std::deque<double> lF_vel_z_history;               // Left foot vertical velocity history
-    std::deque<double> hip_joint_pos_history;          // Hip joint position history
-    std::deque<double> knee_joint_pos_history;         // Knee joint position history
-
-    // History for max values (for normalization)
-    double max_lF_acc_vertical = 21.3960;
-    double max_lF_vel_z = 1.4480;
-    double max_hip_joint_pos = 0.6092;
-    double max_knee_joint_pos = 1.2164;
-    double max_lF_accz_diff = 497.9108;
+    StreamingMedian lF_accz_diff_history{static_cast<size_t>(window_size)};   // Left foot vertical acceleration derivative history
+    StreamingMedian lF_vel_z_history{static_cast<size_t>(window_size)};       // Left foot vertical velocity history
+    StreamingMedian hip_joint_pos_history{static_cast<size_t>(window_size)};  // Hip joint position history
+    StreamingMedian knee_joint_pos_history{static_cast<size_t>(window_size)}; // Knee joint position history
+
+    // Normalization divisors of the five outputs, floor of DecayingMax
+    std::array<double, 5> normalization = {1.0, 1.0, 1.0, 1.0, 1.0};
+
+    // Adaptive normalization, scale holds the current divisors, start the ones initialize() restores
+    NormalizationMode norm_mode = NormalizationMode::RunningMax;
+    double norm_decay = 0.0;                        // per-tick factor exp(-dt / decayTime)
+    double norm_decay_time = 5.0;
+    double norm_percentile = 0.99;
+    std::array<double, 5> scale = {1.0, 1.0, 1.0, 1.0, 1.0};
+    std::array<double, 5> start_scale = {1.0, 1.0, 1.0, 1.0, 1.0};
+    std::array<P2Quantile, 5> abs_quantile;
+    std::array<P2Quantile::State, 5> start_quantile{};
 
     // Previous values for derivatives
     std::array<double, 3> prev_lF_acc_vertical = {0.0, 0.0, 0.0};
@@ -50,35 +75,78 @@ private:
     // Design Butterworth filter coefficients
     void designButterLowPass();
     
-    // Apply median filter to a value using history
-    double applyMedianFilter(double value, std::deque<double>& history);
+    // Apply median filter to a value using history, O(log window_size)
+    double applyMedianFilter(double value, StreamingMedian& history);
     
     // Apply Butterworth filter to each axis
-    std::array<double, 3> applyButterworthFilter(const std::array<double, 3>& input, 
-                                                std::deque<std::array<double, 3>>& history);
+    std::array<double, 3> applyButterworthFilter(const std::array<double, 3>& input);
     
-    // Calculate the sign-preserving normalized value
-    double normalizeWithSign(double value, double max_value);
-
-    std::deque<std::array<double, 3>> lF_acc_output_history;
+    // Update the divisor of output idx with value and return the sign-preserving normalized value
+    double normalizeWithSign(double value, int idx);
 
 public:
+    // Median filter on the thresholded acceleration x/y/z before the Butterworth filter,
+    // off by default since the shipped GT2FCM model was trained without it
+    bool median_filter_acc = false;
+    // Median filter on vertical velocity, joint positions and vertical acceleration derivative, off for the same reason
+    bool median_filter_inputs = false;
+
     DataFilterNormalizer();
     
     // Initialize the filter
     void initialize();
     
-    // Process a single data point in real-time
-    std::vector<double> processData(
+    // Process a single data point in real-time, the five normalized GT2FCM inputs go to out (no allocation)
+    void processData(
         const std::array<double, 3>& lF_acc,           // Left foot acceleration [x,y,z]
         const std::array<double, 3>& lF_rpy,           // Left foot roll and pitch
         double lF_vel_z,                               // Left foot vertical velocity
         double hip_joint_pos,                          // Hip joint position
-        double knee_joint_pos                         // Knee joint position
+        double knee_joint_pos,                         // Knee joint position
+        std::array<double, 5>& out
+    );
+
+    // Same, returning the inputs as a vector
+    std::vector<double> processData(
+        const std::array<double, 3>& lF_acc,
+        const std::array<double, 3>& lF_rpy,
+        double lF_vel_z,
+        double hip_joint_pos,
+        double knee_joint_pos
     );
     
     // Reset the filter states
     void reset();
+
+    // Low-pass cutoff (Hz, below fs/2) and acceleration clipping threshold, redesigns the filter
+    // and restarts it from zero state
+    void setFilterParams(double cutoffFreq, double accThreshold);
+    double getCutoffFrequency() const { return cutoff_freq; }
+    double getAccThreshold() const { return acc_threshold; }
+
+    // Normalization divisors of the outputs in processData order
+    // (vertical acc, vertical vel, hip, knee, vertical acc derivative), must be nonzero
+    void setNormalization(const std::array<double, 5>& divisors);
+    const std::array<double, 5>& getNormalization() const { return normalization; }
+
+    // Maxima of |output| over the recordings the divisors were first tuned on, a starting point for
+    // setNormalization() with models trained on unscaled inputs (the shipped model uses 1.0)
+    static const std::array<double, 5> recordedMaxima;
+
+    // Select how the divisors adapt, restarts them from the normalization divisors
+    void setNormalizationMode(NormalizationMode mode, double decayTime = 5.0, double percentile = 0.99);
+    NormalizationMode getNormalizationMode() const { return norm_mode; }
+    // Divisors in use right now
+    const std::array<double, 5>& getScale() const { return scale; }
+
+    // Current normalization state, e.g. to save at the end of a run
+    NormalizerCalibration getCalibration() const;
+    // Continue from a saved state, initialize()/reset() return to it. The normalization divisors are kept
+    void setCalibration(const NormalizerCalibration& calibration);
+
+    // JSON persistence of a calibration, throw std::runtime_error on I/O or format errors
+    static void saveCalibration(const char* path, const NormalizerCalibration& calibration);
+    static NormalizerCalibration loadCalibration(const char* path);
 };
 
 #endif // DATA_FILTER_H
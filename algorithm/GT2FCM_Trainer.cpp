@@ -0,0 +1,354 @@
+#include "GT2FCM_Trainer.h"
+#include "GT2FIS_Model_File.h"
+#include "Data_Filter.h"
+#include "work_stealing_pool.h"
+#include "Eigen/Dense"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+// samples per Eigen block inside a task, columns of the SoA block
+const Eigen::Index blockSize = 256;
+}
+
+GT2FCM_Trainer::GT2FCM_Trainer(int inputDim) : dim(inputDim) {
+    if (inputDim <= 0) {
+        throw std::invalid_argument("Input dimension must be positive");
+    }
+}
+
+void GT2FCM_Trainer::addSample(const double* x, double y) {
+    for (int j = 0; j < dim; j++) {
+        points.push_back(static_cast<float>(x[j]));
+    }
+    labels.push_back(static_cast<float>(y));
+}
+
+size_t GT2FCM_Trainer::addSequence(const std::vector<ContactSensorFrame>& frames, double touchThreshold,
+                                   const std::array<double, 5>& normalization, size_t skip) {
+    if (dim != 5) {
+        throw std::invalid_argument("addSequence needs the 5 DataFilterNormalizer inputs");
+    }
+    DataFilterNormalizer filter;
+    filter.setNormalization(normalization);
+    size_t added = 0;
+    std::array<double, 5> input;
+    for (size_t k = 0; k < frames.size(); k++) {
+        const ContactSensorFrame& f = frames[k];
+        filter.processData(f.acc, f.rpy, f.linear_vel[2], f.hip_joint_pos, f.knee_joint_pos, input);
+        if (k < skip) {
+            continue;
+        }
+        addSample(input.data(), f.touch >= touchThreshold ? 1.0 : 0.0);
+        added++;
+    }
+    return added;
+}
+
+void GT2FCM_Trainer::clearSamples() {
+    points.clear();
+    points.shrink_to_fit();
+    labels.clear();
+    labels.shrink_to_fit();
+}
+
+void GT2FCM_Trainer::Accumulator::reset(int r, int dims) {
+    weight.assign(r, 0.0);
+    sums.assign(r * dims, 0.0);
+    dispersion.assign(r, 0.0);
+    label.assign(r, 0.0);
+}
+
+void GT2FCM_Trainer::Accumulator::add(const Accumulator& o) {
+    for (size_t i = 0; i < weight.size(); i++) {
+        weight[i] += o.weight[i];
+        dispersion[i] += o.dispersion[i];
+        label[i] += o.label[i];
+    }
+    for (size_t i = 0; i < sums.size(); i++) {
+        sums[i] += o.sums[i];
+    }
+}
+
+// k-means++ on the first initSamples (shuffled) samples, in the joint space
+void GT2FCM_Trainer::seedCenters(const GT2FCM_TrainerOptions& opt, std::vector<double>& centers) const {
+    const int dims = dim + 1;
+    const size_t n = std::min(labels.size(), std::max<size_t>(opt.initSamples, opt.numRules));
+    auto coord = [&](size_t s, int j) {
+        return j < dim ? double(points[s * dim + j]) : opt.outputWeight * labels[s];
+    };
+    std::mt19937 rng(opt.seed);
+    centers.assign(opt.numRules * dims, 0.0);
+    std::vector<double> best(n, std::numeric_limits<double>::infinity());
+    size_t pick = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+    for (int i = 0; i < opt.numRules; i++) {
+        for (int j = 0; j < dims; j++) {
+            centers[i * dims + j] = coord(pick, j);
+        }
+        double total = 0.0;
+        for (size_t s = 0; s < n; s++) {
+            double dist = 0.0;
+            for (int j = 0; j < dims; j++) {
+                const double diff = coord(s, j) - centers[i * dims + j];
+                dist += diff * diff;
+            }
+            best[s] = std::min(best[s], dist);
+            total += best[s];
+        }
+        if (total <= 0.0) {
+            pick = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+            continue;
+        }
+        double u = std::uniform_real_distribution<double>(0.0, total)(rng);
+        for (pick = 0; pick + 1 < n && u >= best[pick]; pick++) {
+            u -= best[pick];
+        }
+    }
+}
+
+// FCM sums of samples [begin, end) against fixed centres:
+// u_ik = d_ik^-p / sum_l d_lk^-p with p = 1/(m-1), evaluated in the log domain so small distances do not overflow
+void GT2FCM_Trainer::accumulate(size_t begin, size_t end, const std::vector<double>& centers, double m,
+                                double outputWeight, Accumulator& acc) const {
+    const int r = static_cast<int>(acc.weight.size());
+    const int dims = dim + 1;
+    const double p = 1.0 / (m - 1.0);
+    Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> C(centers.data(), r, dims);
+    const Eigen::VectorXd centerNorm = C.rowwise().squaredNorm();
+    Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> sums(acc.sums.data(), r, dims);
+    Eigen::Map<Eigen::VectorXd> weight(acc.weight.data(), r);
+    Eigen::Map<Eigen::VectorXd> dispersion(acc.dispersion.data(), r);
+    Eigen::Map<Eigen::VectorXd> label(acc.label.data(), r);
+
+    Eigen::MatrixXd X(dims, blockSize);
+    Eigen::ArrayXXd D(r, blockSize), U(r, blockSize);
+    for (size_t start = begin; start < end; start += blockSize) {
+        const Eigen::Index B = static_cast<Eigen::Index>(std::min<size_t>(blockSize, end - start));
+        // AoS floats -> SoA block, the label scaled as last coordinate
+        X.resize(dims, B);
+        X.topRows(dim) = Eigen::Map<const Eigen::MatrixXf>(points.data() + start * dim, dim, B).cast<double>();
+        X.row(dim) = Eigen::Map<const Eigen::RowVectorXf>(labels.data() + start, B).cast<double>() * outputWeight;
+
+        // squared distances |c|^2 - 2 c.x + |x|^2 with one GEMM
+        D.resize(r, B);
+        D = (-2.0 * (C * X)).array();
+        D.colwise() += centerNorm.array();
+        D.rowwise() += X.colwise().squaredNorm().array();
+        D = D.max(1e-10);
+
+        U.resize(r, B);
+        U = D.log();
+        const Eigen::ArrayXXd minLog = U.colwise().minCoeff();
+        U = (-p * (U.rowwise() - minLog.row(0)));
+        const Eigen::ArrayXXd logSum = U.exp().colwise().sum().log();
+        U = (m * (U.rowwise() - logSum.row(0))).exp();     // u^m
+
+        weight += U.rowwise().sum().matrix();
+        dispersion += (U * D).rowwise().sum().matrix();
+        sums.noalias() += U.matrix() * X.transpose();
+        label += U.matrix() * Eigen::Map<const Eigen::VectorXf>(labels.data() + start, B).cast<double>();
+    }
+}
+
+void GT2FCM_Trainer::train(const GT2FCM_TrainerOptions& opt) {
+    const int r = opt.numRules;
+    const int q = opt.numMF;
+    const int dims = dim + 1;
+    if (r <= 0 || q <= 0 || opt.batchSize == 0 || opt.epochs < 0 || opt.refinePasses < 0 || opt.outputWeight < 0.0) {
+        throw std::invalid_argument("Invalid GT2FCM trainer options");
+    }
+    if (!(opt.fuzzifierMin > 1.0) || opt.fuzzifierMax < opt.fuzzifierMin) {
+        throw std::invalid_argument("Fuzzifiers must satisfy 1 < min <= max");
+    }
+    const size_t n = labels.size();
+    if (n < static_cast<size_t>(r)) {
+        throw std::invalid_argument("Fewer samples than rules");
+    }
+
+    // shuffle once, mini-batches are then contiguous slices
+    {
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(opt.seed));
+        std::vector<float> p(points.size()), l(n);
+        for (size_t s = 0; s < n; s++) {
+            std::copy(points.begin() + order[s] * dim, points.begin() + (order[s] + 1) * dim, p.begin() + s * dim);
+            l[s] = labels[order[s]];
+        }
+        points.swap(p);
+        labels.swap(l);
+    }
+
+    std::vector<double> seeds;
+    seedCenters(opt, seeds);
+
+    WorkStealingPool pool(opt.threads);
+    std::vector<Accumulator> workerAcc(pool.size());
+    statBatches = 0;
+    statStolen = 0;
+
+    // sums over [begin, end), split into tasks over the pool
+    auto pass = [&](size_t begin, size_t end, const std::vector<double>& centers, double m, Accumulator& total) {
+        const size_t taskSize = std::max<size_t>(4 * blockSize, (end - begin + 4 * pool.size() - 1) / (4 * pool.size()));
+        const size_t tasks = (end - begin + taskSize - 1) / taskSize;
+        for (Accumulator& a : workerAcc) {
+            a.reset(r, dims);
+        }
+        pool.parallelFor(tasks, [&](size_t t, unsigned w) {
+            const size_t b = begin + t * taskSize;
+            accumulate(b, std::min(b + taskSize, end), centers, m, opt.outputWeight, workerAcc[w]);
+        });
+        statStolen += pool.stolen();
+        total.reset(r, dims);
+        for (const Accumulator& a : workerAcc) {
+            total.add(a);
+        }
+    };
+
+    std::vector<std::vector<double>> runCenters(q);
+    std::vector<Accumulator> runStats(q);
+    std::vector<double> fuzzifier(q);
+    for (int k = 0; k < q; k++) {
+        const double m = q == 1 ? 0.5 * (opt.fuzzifierMin + opt.fuzzifierMax)
+                                : opt.fuzzifierMin + (opt.fuzzifierMax - opt.fuzzifierMin) * k / (q - 1);
+        fuzzifier[k] = m;
+        std::vector<double> centers = seeds;
+        std::vector<double> counts(r, 0.0);
+        Accumulator acc;
+
+        // mini-batch FCM, centre i moves towards the batch mean by S_i / (accumulated S_i)
+        for (int epoch = 0; epoch < opt.epochs; epoch++) {
+            const std::vector<double> before = centers;
+            for (size_t b = 0; b < n; b += opt.batchSize) {
+                pass(b, std::min(b + opt.batchSize, n), centers, m, acc);
+                for (int i = 0; i < r; i++) {
+                    if (acc.weight[i] <= 0.0) {
+                        continue;
+                    }
+                    counts[i] += acc.weight[i];
+                    const double eta = acc.weight[i] / counts[i];
+                    for (int j = 0; j < dims; j++) {
+                        centers[i * dims + j] += eta * (acc.sums[i * dims + j] / acc.weight[i] - centers[i * dims + j]);
+                    }
+                }
+                statBatches++;
+            }
+            double shift = 0.0;
+            for (size_t j = 0; j < centers.size(); j++) {
+                shift = std::max(shift, std::abs(centers[j] - before[j]));
+            }
+            if (shift < opt.tolerance) {
+                break;
+            }
+        }
+
+        // full-batch FCM iterations
+        for (int it = 0; it < opt.refinePasses; it++) {
+            pass(0, n, centers, m, acc);
+            for (int i = 0; i < r; i++) {
+                if (acc.weight[i] > 0.0) {
+                    for (int j = 0; j < dims; j++) {
+                        centers[i * dims + j] = acc.sums[i * dims + j] / acc.weight[i];
+                    }
+                }
+            }
+        }
+
+        pass(0, n, centers, m, runStats[k]);
+        runCenters[k] = centers;
+    }
+
+    // match the clusters of every run to the run with m closest to 2, nearest pairs first
+    int ref = 0;
+    for (int k = 1; k < q; k++) {
+        if (std::abs(fuzzifier[k] - 2.0) < std::abs(fuzzifier[ref] - 2.0)) {
+            ref = k;
+        }
+    }
+    std::vector<std::vector<int>> match(q, std::vector<int>(r));
+    for (int k = 0; k < q; k++) {
+        std::vector<std::pair<double, std::pair<int, int>>> pairs;
+        for (int i = 0; i < r; i++) {
+            for (int c = 0; c < r; c++) {
+                double dist = 0.0;
+                for (int j = 0; j < dims; j++) {
+                    const double diff = runCenters[ref][i * dims + j] - runCenters[k][c * dims + j];
+                    dist += diff * diff;
+                }
+                pairs.push_back({dist, {i, c}});
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        std::vector<bool> usedRule(r, false), usedCluster(r, false);
+        for (const auto& pr : pairs) {
+            const int i = pr.second.first, c = pr.second.second;
+            if (!usedRule[i] && !usedCluster[c]) {
+                match[k][i] = c;
+                usedRule[i] = usedCluster[c] = true;
+            }
+        }
+    }
+
+    R.assign(q, std::vector<std::vector<double>>(r, std::vector<double>(dim + 1, 0.0)));
+    SM.assign(r, std::vector<double>(q, 0.0));
+    for (int i = 0; i < r; i++) {
+        double maxTightness = 0.0;
+        for (int k = 0; k < q; k++) {
+            const int c = match[k][i];
+            const Accumulator& st = runStats[k];
+            for (int j = 0; j < dim; j++) {
+                R[k][i][j] = runCenters[k][c * dims + j];
+            }
+            const double y = st.weight[c] > 0.0 ? st.label[c] / st.weight[c] : 0.0;
+            R[k][i][dim] = opt.binaryOutput ? (y >= 0.5 ? 1.0 : 0.0) : y;
+            const double spread = st.weight[c] > 0.0 ? st.dispersion[c] / st.weight[c] : 0.0;
+            SM[i][k] = 1.0 / std::max(spread, 1e-12);
+            maxTightness = std::max(maxTightness, SM[i][k]);
+        }
+        for (int k = 0; k < q; k++) {
+            SM[i][k] /= maxTightness;
+        }
+    }
+    statObjective = std::accumulate(runStats[ref].dispersion.begin(), runStats[ref].dispersion.end(), 0.0);
+}
+
+std::vector<double> GT2FCM_Trainer::unr() const {
+    if (!trained()) {
+        throw std::logic_error("GT2FCM trainer has no result");
+    }
+    // same reduction as GT2FCM::computeUNR
+    const size_t q = R.size(), r = SM.size();
+    std::vector<double> table(r * (dim + 1), 0.0);
+    for (size_t i = 0; i < r; i++) {
+        double denominator = 0.0;
+        for (size_t k = 0; k < q; k++) {
+            denominator += SM[i][k];
+        }
+        denominator = std::max(denominator, 1e-10);
+        for (int j = 0; j <= dim; j++) {
+            double numerator = 0.0;
+            for (size_t k = 0; k < q; k++) {
+                numerator += SM[i][k] * R[k][i][j];
+            }
+            table[i * (dim + 1) + j] = numerator / denominator;
+        }
+    }
+    return table;
+}
+
+void GT2FCM_Trainer::save(const char* jsonPath, const std::string& name, const std::string& description,
+                          const std::array<double, 5>& normalization) const {
+    const std::vector<double> table = unr();
+    std::vector<double> norm(normalization.begin(), normalization.end());
+    norm.resize(dim, 1.0);
+    std::vector<std::string> inputNames;
+    if (dim == 5) {
+        inputNames = {"acc_vertical", "vel_vertical", "hip_joint_pos", "knee_joint_pos", "acc_vertical_diff"};
+    }
+    GT2FCM_ModelFile::save(jsonPath, name, description, table.data(), norm.data(),
+                           static_cast<int>(SM.size()), dim, static_cast<int>(R.size()), fcmConstant(), inputNames);
+}
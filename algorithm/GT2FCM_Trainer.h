@@ -0,0 +1,126 @@
+#ifndef GT2FCM_TRAINER_H
+#define GT2FCM_TRAINER_H
+
+#include <vector>
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "Contact_Estimator.h"
+
+/**
+ * @brief Settings of GT2FCM_Trainer::train
+ */
+struct GT2FCM_TrainerOptions {
+    int numRules{13};                   // clusters, rules of the trained model
+    int numMF{7};                       // fuzzifier runs, one membership function each
+    double fuzzifierMin{1.5};           // fuzzifiers of the runs are spread evenly over [min, max]
+    double fuzzifierMax{2.5};
+    size_t batchSize{65536};            // samples per mini-batch update
+    int epochs{10};                     // mini-batch passes over the data, at most
+    double tolerance{1e-5};             // stop when no center moves further in an epoch
+    int refinePasses{3};                // full-batch FCM iterations after the mini-batch epochs
+    double outputWeight{1.0};           // scale of the label as clustering coordinate
+    bool binaryOutput{true};            // round rule outputs to 0/1 like the shipped model
+    size_t initSamples{20000};          // subsample for the k-means++ seeding
+    unsigned threads{0};                // worker threads, 0 uses all hardware threads
+    uint32_t seed{1};
+};
+
+/**
+ * @brief Fits the GT2FCM rule base to labelled samples
+ *
+ * Every sample is a normalized input (DataFilterNormalizer output) and a contact
+ * label. Clusters are searched in the joint space (input, outputWeight * label),
+ * so every cluster centre is one rule: the input part is the antecedent, the
+ * label mean inside the cluster the consequent.
+ *
+ * The type-2 part comes from q = numMF fuzzy C-means runs with fuzzifiers spread
+ * over [fuzzifierMin, fuzzifierMax], all started from the same k-means++ seeds.
+ * Run k gives layer k of the rule base R (q x r x (d+1)); clusters of the runs are
+ * matched to the run with the fuzzifier closest to 2. The uncertainty weight
+ * SM[i][k] is the inverse fuzzy dispersion of rule i in run k, scaled to max 1,
+ * so tight clusters dominate the reduced UNR table.
+ *
+ * Each run is a mini-batch FCM (per-centre learning rate 1 / accumulated
+ * membership) followed by a few full-batch passes. A batch is split over a
+ * WorkStealingPool, every worker keeps its own accumulators, and the distance,
+ * membership and centre sums run on Eigen array/GEMM kernels.
+ */
+class GT2FCM_Trainer {
+public:
+    explicit GT2FCM_Trainer(int inputDim = ContactEstimator::inputDim);
+
+    /**
+     * @brief Add one normalized sample
+     *
+     * @param x inputDim values
+     * @param y Label, 1 for contact
+     */
+    void addSample(const double* x, double y);
+
+    /**
+     * @brief Run a sequence through a fresh DataFilterNormalizer and add every tick
+     *
+     * @param frames Sensor frames in time order, touch >= touchThreshold is the label
+     * @param normalization Divisors of DataFilterNormalizer
+     * @param skip Ticks dropped at the start while the filter settles
+     * @return Number of samples added
+     */
+    size_t addSequence(const std::vector<ContactSensorFrame>& frames, double touchThreshold = 5.0,
+                       const std::array<double, 5>& normalization = {1.0, 1.0, 1.0, 1.0, 1.0},
+                       size_t skip = 50);
+
+    size_t sampleNum() const { return labels.size(); }
+    int inputDim() const { return dim; }
+    void clearSamples();
+
+    /**
+     * @brief Fit the rule base, replaces the result of an earlier call
+     *
+     * Throws std::invalid_argument on bad options or fewer samples than rules.
+     */
+    void train(const GT2FCM_TrainerOptions& options = GT2FCM_TrainerOptions());
+
+    bool trained() const { return !R.empty(); }
+    const std::vector<std::vector<std::vector<double>>>& ruleBase() const { return R; }       // q x r x (d+1)
+    const std::vector<std::vector<double>>& uncertaintyWeights() const { return SM; }        // r x q
+    std::vector<double> unr() const;                                                        // row-major r x (d+1)
+    double fcmConstant() const { return 2.0; }
+
+    /**
+     * @brief Write the trained model, see GT2FCM_ModelFile::save
+     */
+    void save(const char* jsonPath, const std::string& name, const std::string& description,
+              const std::array<double, 5>& normalization = {1.0, 1.0, 1.0, 1.0, 1.0}) const;
+
+    // statistics of the last train() call
+    size_t batchUpdates() const { return statBatches; }
+    double objective() const { return statObjective; }        // fuzzy objective of the m closest to 2
+    size_t stolenTasks() const { return statStolen; }
+
+private:
+    // per worker sums of one pass: membership^m, membership^m * point, membership^m * distance, * label
+    struct Accumulator {
+        std::vector<double> weight, sums, dispersion, label;
+        void reset(int r, int dims);
+        void add(const Accumulator& o);
+    };
+
+    int dim;
+    std::vector<float> points;                      // row-major n x dim
+    std::vector<float> labels;
+
+    std::vector<std::vector<std::vector<double>>> R;
+    std::vector<std::vector<double>> SM;
+    size_t statBatches{0};
+    double statObjective{0};
+    size_t statStolen{0};
+
+    void seedCenters(const GT2FCM_TrainerOptions& opt, std::vector<double>& centers) const;
+    void accumulate(size_t begin, size_t end, const std::vector<double>& centers, double m,
+                    double outputWeight, Accumulator& acc) const;
+};
+
+#endif // GT2FCM_TRAINER_H
@@ -1,15 +1,19 @@
 #include "GT2FIS_Contact.h"
+#include "GT2FIS_Model_File.h"
+#include "Eigen/Dense"
 
 // Default constructor
-GT2FCM::GT2FCM() : r(0), d(0), q(0), m(2.0) {
+GT2FCM::GT2FCM() : r(0), d(0), q(0), m(2.0), closedFormM2(true) {
 }
 
 // Constructor with parameters
 GT2FCM::GT2FCM(const std::vector<std::vector<std::vector<double>>>& ruleBase,
                const std::vector<std::vector<double>>& uncertaintyWeights,
-               int numRules, int inputDim, int numMF) 
-    : R(ruleBase), SM(uncertaintyWeights), r(numRules), d(inputDim), q(numMF), m(2.0) {
+               int numRules, int inputDim, int numMF, double fcmConstant) 
+    : R(ruleBase), SM(uncertaintyWeights), r(numRules), d(inputDim), q(numMF) {
     
+    setFcmConstant(fcmConstant);
+
     // Initialize the UNR matrix with proper dimensions (r x (d+1))
     UNR.resize(r, std::vector<double>(d+1, 0.0));
     
@@ -22,6 +26,15 @@ GT2FCM::~GT2FCM() {
     // Nothing special to clean up
 }
 
+// Set the FCM constant and select the membership path
+void GT2FCM::setFcmConstant(double fcmConstant) {
+    if (fcmConstant <= 1.0) {
+        throw std::invalid_argument("FCM constant m must be greater than 1");
+    }
+    m = fcmConstant;
+    closedFormM2 = (m == 2.0);
+}
+
 // Set the rule base matrix
 void GT2FCM::setRuleBase(const std::vector<std::vector<std::vector<double>>>& ruleBase,
                          int numRules, int inputDim, int numMF) {
@@ -49,6 +62,27 @@ void GT2FCM::setUncertaintyWeights(const std::vector<std::vector<double>>& uncer
     }
 }
 
+// Use a precomputed UNR, R and SM are not needed any more
+void GT2FCM::setUNR(const double* unr, int numRules, int inputDim, double fcmConstant) {
+    setFcmConstant(fcmConstant);
+    R.clear();
+    SM.clear();
+    r = numRules;
+    d = inputDim;
+    q = 0;
+    UNR.assign(r, std::vector<double>(d+1, 0.0));
+    for (int i = 0; i < r; i++) {
+        std::copy(unr + i * (d+1), unr + (i+1) * (d+1), UNR[i].begin());
+    }
+}
+
+// Load a model file, the mapping is released once UNR is copied
+void GT2FCM::loadModel(const char* path) {
+    GT2FCM_ModelFile model(path);
+    setUNR(model.unr(), model.numRules(), model.inputDim(), model.fcmConstant());
+    q = model.numMF();
+}
+
 // Compute the uncertainty rule base matrix
 void GT2FCM::computeUNR() {
     // Step 1: Calculate uncertainty rule base matrix UNR
@@ -97,22 +131,33 @@ std::vector<double> GT2FCM::computeDistance(const std::vector<double>& inputData
 }
 
 // Compute FCM membership vector
+//   mu_i = sum_l (d_l / d_i)^(1/(m-1)) = (sum_l d_l^(1/(m-1))) / d_i^(1/(m-1))
+// so the r x r pow calls of the pairwise form reduce to r (or none for m == 2)
 std::vector<double> GT2FCM::computeMembership(const std::vector<double>& distances) {
     // Step 4: Calculate FCM membership vector μ
     std::vector<double> mu(r, 0.0);
     
-    for (int i = 0; i < r; i++) {
-        // Avoid division by zero
-        double dist_i = (distances[i] < 1e-10) ? 1e-10 : distances[i];
-        double sum_ratio = 0.0;
-        
+    if (closedFormM2) {
+        double sum_dist = 0.0;
         for (int l = 0; l < r; l++) {
+            sum_dist += distances[l];
+        }
+        for (int i = 0; i < r; i++) {
             // Avoid division by zero
-            double dist_l = distances[l];
-            sum_ratio += std::pow(dist_l / dist_i, 1.0 / (m - 1.0));
+            double dist_i = (distances[i] < 1e-10) ? 1e-10 : distances[i];
+            mu[i] = sum_dist / dist_i;
+        }
+    } else {
+        const double expo = 1.0 / (m - 1.0);
+        double sum_pow = 0.0;
+        for (int l = 0; l < r; l++) {
+            sum_pow += std::pow(distances[l], expo);
+        }
+        for (int i = 0; i < r; i++) {
+            // Avoid division by zero
+            double dist_i = (distances[i] < 1e-10) ? 1e-10 : distances[i];
+            mu[i] = sum_pow / std::pow(dist_i, expo);
         }
-        
-        mu[i] = sum_ratio;
     }
     
     return mu;
@@ -171,4 +216,90 @@ double GT2FCM::calculate(const std::vector<double>& inputData) {
     double output = numerator / denominator;
     
     return output;
-}
\ No newline at end of file
+}
+
+// Calculate outputs for n samples, same steps as calculate() on SoA blocks
+void GT2FCM::calculateBatch(const double* inputs, size_t n, double* out) {
+#ifndef EIGEN_VECTORIZE
+    // No SIMD instruction set enabled, plain per-sample loop
+    std::vector<double> sample(d);
+    for (size_t k = 0; k < n; k++) {
+        sample.assign(inputs + k * d, inputs + (k + 1) * d);
+        out[k] = calculate(sample);
+    }
+#else
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> ArrayRow;
+    typedef Eigen::Map<ArrayRow> MapRow;
+    typedef Eigen::Map<Eigen::ArrayXd> MapVec;
+
+    if (r == 0 || d == 0) {
+        throw std::invalid_argument("Rule base is not set");
+    }
+    batchX.resize(d * batchBlockSize);
+    batchD.resize(r * batchBlockSize);
+    batchAux.resize(4 * batchBlockSize);
+
+    for (size_t start = 0; start < n; start += batchBlockSize) {
+        const Eigen::Index B = static_cast<Eigen::Index>(std::min(batchBlockSize, n - start));
+
+        // AoS -> SoA: row n of X holds input n of every sample in the block
+        MapRow X(batchX.data(), d, B);
+        X = Eigen::Map<const ArrayRow>(inputs + start * d, B, d).transpose();
+
+        // Step 3: distances, row i of D holds the distance to rule i
+        MapRow D(batchD.data(), r, B);
+        for (int i = 0; i < r; i++) {
+            D.row(i) = (X.row(0) - UNR[i][0]).square();
+            for (int k = 1; k < d; k++) {
+                D.row(i) += (X.row(k) - UNR[i][k]).square();
+            }
+        }
+
+        // Step 4: membership, O(r) form of computeMembership, written back into D
+        MapVec S(batchAux.data(), B);
+        if (closedFormM2) {
+            S = D.row(0).transpose();
+            for (int l = 1; l < r; l++) {
+                S += D.row(l).transpose();
+            }
+            for (int i = 0; i < r; i++) {
+                D.row(i) = S.transpose() / D.row(i).max(1e-10);
+            }
+        } else {
+            const double expo = 1.0 / (m - 1.0);
+            S = D.row(0).transpose().pow(expo);
+            for (int l = 1; l < r; l++) {
+                S += D.row(l).transpose().pow(expo);
+            }
+            for (int i = 0; i < r; i++) {
+                D.row(i) = S.transpose() / D.row(i).max(1e-10).pow(expo);
+            }
+        }
+
+        // Step 5: normalize membership to C
+        MapVec minMu(batchAux.data() + batchBlockSize, B);
+        MapVec range(batchAux.data() + 2 * batchBlockSize, B);
+        minMu = D.row(0).transpose();
+        range = D.row(0).transpose();
+        for (int i = 1; i < r; i++) {
+            minMu = minMu.min(D.row(i).transpose());
+            range = range.max(D.row(i).transpose());
+        }
+        range -= minMu;
+        for (int i = 0; i < r; i++) {
+            D.row(i) = (range.transpose() > 0.0).select((D.row(i) - minMu.transpose()) / range.transpose(), 1.0 / r);
+        }
+
+        // Step 6: weighted average of the UNR output part, the sum buffer S is reused
+        MapVec numerator(batchAux.data(), B);
+        MapVec denominator(batchAux.data() + 3 * batchBlockSize, B);
+        numerator = D.row(0).transpose() * UNR[0][d];
+        denominator = D.row(0).transpose();
+        for (int i = 1; i < r; i++) {
+            numerator += D.row(i).transpose() * UNR[i][d];
+            denominator += D.row(i).transpose();
+        }
+        MapVec(out + start, B) = numerator / denominator.max(1e-10);
+    }
+#endif
+}
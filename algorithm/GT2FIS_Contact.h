@@ -23,10 +23,11 @@ public:
      * @param numRules Number of rules
      * @param inputDim Input dimension
      * @param numMF Number of membership functions
+     * @param fcmConstant FCM fuzzifier m (> 1), m == 2 selects the closed-form membership
      */
     GT2FCM(const std::vector<std::vector<std::vector<double>>>& ruleBase,
            const std::vector<std::vector<double>>& uncertaintyWeights,
-           int numRules, int inputDim, int numMF);
+           int numRules, int inputDim, int numMF, double fcmConstant = 2.0);
 
     /**
      * @brief Default constructor
@@ -56,6 +57,25 @@ public:
      */
     void setUncertaintyWeights(const std::vector<std::vector<double>>& uncertaintyWeights);
 
+    /**
+     * @brief Use a precomputed uncertainty rule base
+     * 
+     * Replaces the rule base and uncertainty weights, UNR is used as given.
+     * 
+     * @param unr Row-major numRules x (inputDim+1) UNR table
+     * @param numRules Number of rules
+     * @param inputDim Input dimension
+     * @param fcmConstant FCM fuzzifier m (> 1)
+     */
+    void setUNR(const double* unr, int numRules, int inputDim, double fcmConstant = 2.0);
+
+    /**
+     * @brief Load UNR and FCM constant from a model file, see GT2FCM_ModelFile
+     * 
+     * @param path JSON sidecar or binary model file
+     */
+    void loadModel(const char* path);
+
     /**
      * @brief Calculate output for given input data
      * 
@@ -64,6 +84,20 @@ public:
      */
     double calculate(const std::vector<double>& inputData);
 
+    /**
+     * @brief Calculate outputs for many samples at once
+     * 
+     * Samples are transposed block by block into a structure-of-arrays layout
+     * and evaluated with Eigen array kernels, so the distance, membership and
+     * defuzzification steps run on SIMD lanes (SSE/AVX2/NEON, whatever Eigen
+     * is compiled for). Without SIMD support it falls back to calculate().
+     * 
+     * @param inputs Input samples, row-major n x d
+     * @param n Number of samples
+     * @param out Output buffer of n values
+     */
+    void calculateBatch(const double* inputs, size_t n, double* out);
+
 private:
     // Member variables
     std::vector<std::vector<std::vector<double>>> R;     // Rule base matrix
@@ -73,16 +107,19 @@ private:
     int d;                                              // Input dimension
     int q;                                              // Number of MFs
     double m;                                           // FCM constant
+    bool closedFormM2;                                  // m == 2, membership is (sum d_l) / d_i
 
-    //Data normalization
-    
-
-
+    // Scratch buffers for calculateBatch, kept to avoid reallocation
+    static constexpr size_t batchBlockSize = 256;
+    std::vector<double> batchX;                         // inputs, SoA d x block
+    std::vector<double> batchD;                         // distances, r x block
+    std::vector<double> batchAux;                       // per-sample sums/min/max, 4 x block
 
     // Private helper methods
     void computeUNR();
     std::vector<double> computeDistance(const std::vector<double>& inputData);
     std::vector<double> computeMembership(const std::vector<double>& distances);
+    void setFcmConstant(double fcmConstant);
     std::vector<double> normalizeMembers(const std::vector<double>& mu);
 };
 
@@ -0,0 +1,220 @@
+#ifndef GT2FCM_FIXED_H
+#define GT2FCM_FIXED_H
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+/**
+ * @brief Fixed-size General Type-2 Fuzzy C-Means inference engine
+ *
+ * Same inference as GT2FCM, but the number of rules and the input dimension
+ * are compile-time constants. The uncertainty rule base UNR is stored as one
+ * contiguous row-major r x (d+1) table and all per-call scratch buffers live
+ * on the stack, so calculate() never touches the heap.
+ *
+ * @tparam Rules Number of rules (r)
+ * @tparam Dim   Input dimension (d)
+ */
+template<int Rules, int Dim>
+class GT2FCM_Fixed {
+public:
+    static constexpr int numRules = Rules;
+    static constexpr int inputDim = Dim;
+    static constexpr int rowSize = Dim + 1;
+
+    /**
+     * @brief Default constructor, UNR is zero until setModel() is called
+     */
+    GT2FCM_Fixed() : m(2.0), closedFormM2(true) {
+        UNR.fill(0.0);
+    }
+
+    /**
+     * @brief Constructor with parameters
+     *
+     * @param ruleBase Rule base matrix (3D), layout q x r x (d+1)
+     * @param uncertaintyWeights Uncertainty weight matrix (2D), layout r x q
+     * @param numMF Number of membership functions
+     * @param fcmConstant FCM fuzzifier m (> 1), m == 2 selects the closed-form membership
+     */
+    GT2FCM_Fixed(const std::vector<std::vector<std::vector<double>>>& ruleBase,
+                 const std::vector<std::vector<double>>& uncertaintyWeights,
+                 int numMF, double fcmConstant = 2.0) {
+        if (fcmConstant <= 1.0) {
+            throw std::invalid_argument("FCM constant m must be greater than 1");
+        }
+        m = fcmConstant;
+        closedFormM2 = (m == 2.0);
+        setModel(ruleBase, uncertaintyWeights, numMF);
+    }
+
+    /**
+     * @brief Set the rule base and uncertainty weights, and recompute UNR
+     *
+     * @param ruleBase Rule base matrix (3D), layout q x r x (d+1)
+     * @param uncertaintyWeights Uncertainty weight matrix (2D), layout r x q
+     * @param numMF Number of membership functions
+     */
+    void setModel(const std::vector<std::vector<std::vector<double>>>& ruleBase,
+                  const std::vector<std::vector<double>>& uncertaintyWeights,
+                  int numMF) {
+        if (ruleBase.size() != static_cast<size_t>(numMF) ||
+            uncertaintyWeights.size() != static_cast<size_t>(Rules)) {
+            throw std::invalid_argument("Rule base dimension does not match GT2FCM_Fixed template parameters");
+        }
+        for (int k = 0; k < numMF; k++) {
+            if (ruleBase[k].size() != static_cast<size_t>(Rules)) {
+                throw std::invalid_argument("Rule base dimension does not match GT2FCM_Fixed template parameters");
+            }
+            for (int i = 0; i < Rules; i++) {
+                if (ruleBase[k][i].size() != static_cast<size_t>(rowSize)) {
+                    throw std::invalid_argument("Rule base dimension does not match GT2FCM_Fixed template parameters");
+                }
+            }
+        }
+        for (int i = 0; i < Rules; i++) {
+            if (uncertaintyWeights[i].size() != static_cast<size_t>(numMF)) {
+                throw std::invalid_argument("Uncertainty weights dimension does not match number of MFs");
+            }
+        }
+
+        // Same weighted average as GT2FCM::computeUNR
+        for (int i = 0; i < Rules; i++) {
+            for (int j = 0; j < rowSize; j++) {
+                double numerator = 0.0;
+                double denominator = 0.0;
+
+                for (int k = 0; k < numMF; k++) {
+                    numerator += uncertaintyWeights[i][k] * ruleBase[k][i][j];
+                    denominator += uncertaintyWeights[i][k];
+                }
+
+                // Avoid division by zero
+                if (denominator < 1e-10) {
+                    denominator = 1e-10;
+                }
+
+                UNR[i * rowSize + j] = numerator / denominator;
+            }
+        }
+    }
+
+    /**
+     * @brief Use a precomputed UNR table, e.g. from GT2FCM_ModelFile
+     *
+     * @param unr Row-major Rules x (Dim+1) UNR table
+     * @param fcmConstant FCM fuzzifier m (> 1)
+     */
+    void setUNR(const double* unr, double fcmConstant) {
+        if (fcmConstant <= 1.0) {
+            throw std::invalid_argument("FCM constant m must be greater than 1");
+        }
+        m = fcmConstant;
+        closedFormM2 = (m == 2.0);
+        std::copy(unr, unr + Rules * rowSize, UNR.begin());
+    }
+
+    /**
+     * @brief Calculate output for given input data
+     *
+     * @param inputData Pointer to Dim input values
+     * @return double Predicted output value
+     */
+    double calculate(const double* inputData) const {
+        double distances[Rules];
+        double mu[Rules];
+
+        // Step 3: Calculate distances
+        for (int i = 0; i < Rules; i++) {
+            const double* row = &UNR[i * rowSize];
+            double sum_squared_diff = 0.0;
+            for (int n = 0; n < Dim; n++) {
+                double diff = inputData[n] - row[n];
+                sum_squared_diff += diff * diff;
+            }
+            distances[i] = sum_squared_diff;
+        }
+
+        // Step 4: Calculate FCM membership vector mu, O(r) form of GT2FCM::computeMembership
+        if (closedFormM2) {
+            double sum_dist = 0.0;
+            for (int l = 0; l < Rules; l++) {
+                sum_dist += distances[l];
+            }
+            for (int i = 0; i < Rules; i++) {
+                double dist_i = (distances[i] < 1e-10) ? 1e-10 : distances[i];
+                mu[i] = sum_dist / dist_i;
+            }
+        } else {
+            const double expo = 1.0 / (m - 1.0);
+            double sum_pow = 0.0;
+            for (int l = 0; l < Rules; l++) {
+                sum_pow += std::pow(distances[l], expo);
+            }
+            for (int i = 0; i < Rules; i++) {
+                double dist_i = (distances[i] < 1e-10) ? 1e-10 : distances[i];
+                mu[i] = sum_pow / std::pow(dist_i, expo);
+            }
+        }
+
+        // Step 5: Normalize membership vector, stored back into mu
+        double min_mu = mu[0];
+        double max_mu = mu[0];
+        for (int i = 1; i < Rules; i++) {
+            if (mu[i] < min_mu) min_mu = mu[i];
+            if (mu[i] > max_mu) max_mu = mu[i];
+        }
+        if (max_mu > min_mu) {
+            for (int i = 0; i < Rules; i++) {
+                mu[i] = (mu[i] - min_mu) / (max_mu - min_mu);
+            }
+        } else {
+            for (int i = 0; i < Rules; i++) {
+                mu[i] = 1.0 / Rules;
+            }
+        }
+
+        // Step 6: Calculate predicted output using UNR output part and C
+        double numerator = 0.0;
+        double denominator = 0.0;
+        for (int i = 0; i < Rules; i++) {
+            numerator += mu[i] * UNR[i * rowSize + Dim];
+            denominator += mu[i];
+        }
+
+        // Avoid division by zero
+        if (denominator < 1e-10) {
+            denominator = 1e-10;
+        }
+
+        return numerator / denominator;
+    }
+
+    double calculate(const std::array<double, Dim>& inputData) const {
+        return calculate(inputData.data());
+    }
+
+    double calculate(const std::vector<double>& inputData) const {
+        if (inputData.size() != static_cast<size_t>(Dim)) {
+            throw std::invalid_argument("Input data dimension does not match expected dimension");
+        }
+        return calculate(inputData.data());
+    }
+
+    /**
+     * @brief Read-only access to the flat r x (d+1) UNR table
+     */
+    const std::array<double, Rules * (Dim + 1)>& getUNR() const { return UNR; }
+
+    double getFcmConstant() const { return m; }
+
+private:
+    std::array<double, Rules * (Dim + 1)> UNR;  // Uncertainty rule base, row-major r x (d+1)
+    double m;                                   // FCM constant
+    bool closedFormM2;                          // m == 2, membership is (sum d_l) / d_i
+};
+
+#endif // GT2FCM_FIXED_H
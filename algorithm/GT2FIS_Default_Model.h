@@ -0,0 +1,19 @@
+#ifndef GT2FIS_DEFAULT_MODEL_H
+#define GT2FIS_DEFAULT_MODEL_H
+
+#include <vector>
+
+/**
+ * @brief Shipped GT2FCM rule base for the left foot contact model
+ *
+ * Layout is q x r x (d+1) (7 membership functions, 13 rules, 5 inputs + 1 output),
+ * as expected by GT2FCM::GT2FCM / GT2FCM::setRuleBase.
+ */
+const std::vector<std::vector<std::vector<double>>>& GT2FCM_DefaultRuleBase();
+
+/**
+ * @brief Shipped GT2FCM uncertainty weights, layout r x q
+ */
+const std::vector<std::vector<double>>& GT2FCM_DefaultUncertaintyWeights();
+
+#endif // GT2FIS_DEFAULT_MODEL_H
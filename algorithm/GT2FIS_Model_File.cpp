@@ -0,0 +1,210 @@
+#include "GT2FIS_Model_File.h"
+#include "json/json.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char modelMagic[8] = {'G', 'T', '2', 'F', 'C', 'M', 0, 0};
+const uint32_t endianTag = 0x01020304;
+
+bool endsWith(const std::string &s, const char *suffix) {
+    const size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+std::string directoryOf(const std::string &path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string fileNameOf(const std::string &path) {
+    const size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+}
+
+GT2FCM_ModelFile::GT2FCM_ModelFile(const char *path) {
+    load(path);
+}
+
+GT2FCM_ModelFile::~GT2FCM_ModelFile() {
+    close();
+}
+
+GT2FCM_ModelFile::GT2FCM_ModelFile(GT2FCM_ModelFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+GT2FCM_ModelFile &GT2FCM_ModelFile::operator=(GT2FCM_ModelFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        mapping = other.mapping;
+        mappingSize = other.mappingSize;
+        header = other.header;
+        normTable = other.normTable;
+        unrTable = other.unrTable;
+        modelName = std::move(other.modelName);
+        modelDescription = std::move(other.modelDescription);
+        names = std::move(other.names);
+        other.mapping = nullptr;
+        other.mappingSize = 0;
+        other.header = nullptr;
+        other.normTable = other.unrTable = nullptr;
+    }
+    return *this;
+}
+
+void GT2FCM_ModelFile::close() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+    mapping = nullptr;
+    mappingSize = 0;
+    header = nullptr;
+    normTable = unrTable = nullptr;
+    modelName.clear();
+    modelDescription.clear();
+    names.clear();
+}
+
+void GT2FCM_ModelFile::load(const char *path) {
+    close();
+    const std::string p(path);
+    if (!endsWith(p, ".json")) {
+        mapBinary(p);
+        modelName = fileNameOf(p);
+        return;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Cannot open GT2FCM model " + p);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(ss.str(), root))
+        throw std::runtime_error("Cannot parse GT2FCM model " + p + ": " + reader.getFormattedErrorMessages());
+    if (!root["binary"].isString())
+        throw std::runtime_error("GT2FCM model " + p + " does not name its binary");
+
+    const std::string binary = root["binary"].asString();
+    mapBinary(binary[0] == '/' ? binary : directoryOf(p) + binary);
+
+    const char *dims[3] = {"numRules", "inputDim", "numMF"};
+    const int values[3] = {numRules(), inputDim(), numMF()};
+    for (int i = 0; i < 3; i++) {
+        if (root.isMember(dims[i]) && root[dims[i]].asInt() != values[i]) {
+            close();
+            throw std::runtime_error("GT2FCM model " + p + ": " + dims[i] + " does not match the binary");
+        }
+    }
+    modelName = root.get("name", fileNameOf(p)).asString();
+    modelDescription = root.get("description", "").asString();
+    for (const Json::Value &n : root["inputs"])
+        names.push_back(n.asString());
+}
+
+void GT2FCM_ModelFile::mapBinary(const std::string &binPath) {
+    const int fd = open(binPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open GT2FCM model binary " + binPath);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(GT2FCM_ModelHeader)) {
+        ::close(fd);
+        throw std::runtime_error("GT2FCM model binary " + binPath + " is too short");
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw std::runtime_error("Cannot map GT2FCM model binary " + binPath);
+    mapping = addr;
+    mappingSize = st.st_size;
+
+    const GT2FCM_ModelHeader *h = static_cast<const GT2FCM_ModelHeader *>(addr);
+    const char *error = nullptr;
+    if (memcmp(h->magic, modelMagic, sizeof(modelMagic)) != 0)
+        error = "is not a GT2FCM model";
+    else if (h->version != formatVersion)
+        error = "has an unsupported format version";
+    else if (h->endianTag != endianTag)
+        error = "was written with a different byte order";
+    else if (h->fileSize != mappingSize || h->numRules == 0 || h->inputDim == 0)
+        error = "is truncated or corrupt";
+    else if (h->normOffset % sizeof(double) != 0 || h->unrOffset % sizeof(double) != 0 ||
+             h->normOffset + h->inputDim * sizeof(double) > mappingSize ||
+             h->unrOffset + uint64_t(h->numRules) * (h->inputDim + 1) * sizeof(double) > mappingSize)
+        error = "has tables outside the file";
+    else if (!(h->fcmConstant > 1.0))
+        error = "has an FCM constant <= 1";
+    if (error != nullptr) {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        mappingSize = 0;
+        throw std::runtime_error("GT2FCM model binary " + binPath + " " + error);
+    }
+
+    header = h;
+    normTable = reinterpret_cast<const double *>(static_cast<const char *>(addr) + h->normOffset);
+    unrTable = reinterpret_cast<const double *>(static_cast<const char *>(addr) + h->unrOffset);
+}
+
+void GT2FCM_ModelFile::save(const char *jsonPath, const std::string &name, const std::string &description,
+                            const double *unr, const double *normalization,
+                            int numRules, int inputDim, int numMF, double fcmConstant,
+                            const std::vector<std::string> &inputNames) {
+    std::string binPath(jsonPath);
+    if (!endsWith(binPath, ".json"))
+        throw std::invalid_argument("GT2FCM model sidecar must end with .json");
+    binPath.replace(binPath.size() - 5, 5, ".bin");
+    if (!inputNames.empty() && inputNames.size() != static_cast<size_t>(inputDim))
+        throw std::invalid_argument("Number of input names does not match input dimension");
+
+    GT2FCM_ModelHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, modelMagic, sizeof(modelMagic));
+    h.version = formatVersion;
+    h.endianTag = endianTag;
+    h.numRules = numRules;
+    h.inputDim = inputDim;
+    h.numMF = numMF;
+    h.fcmConstant = fcmConstant;
+    h.normOffset = sizeof(GT2FCM_ModelHeader);
+    h.unrOffset = h.normOffset + inputDim * sizeof(double);
+    h.fileSize = h.unrOffset + uint64_t(numRules) * (inputDim + 1) * sizeof(double);
+
+    std::ofstream bin(binPath, std::ios::binary | std::ios::trunc);
+    bin.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    bin.write(reinterpret_cast<const char *>(normalization), inputDim * sizeof(double));
+    bin.write(reinterpret_cast<const char *>(unr), numRules * (inputDim + 1) * sizeof(double));
+    if (!bin)
+        throw std::runtime_error("Cannot write GT2FCM model binary " + binPath);
+
+    Json::Value root;
+    root["name"] = name;
+    root["description"] = description;
+    root["binary"] = fileNameOf(binPath);
+    root["formatVersion"] = formatVersion;
+    root["numRules"] = numRules;
+    root["inputDim"] = inputDim;
+    root["numMF"] = numMF;
+    root["fcmConstant"] = fcmConstant;
+    root["inputs"] = Json::Value(Json::arrayValue);
+    for (const std::string &n : inputNames)
+        root["inputs"].append(n);
+    root["normalization"] = Json::Value(Json::arrayValue);
+    for (int i = 0; i < inputDim; i++)
+        root["normalization"].append(normalization[i]);
+
+    std::ofstream json(jsonPath, std::ios::trunc);
+    json << Json::StyledWriter().write(root);
+    if (!json)
+        throw std::runtime_error(std::string("Cannot write GT2FCM model sidecar ") + jsonPath);
+}
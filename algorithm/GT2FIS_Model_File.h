@@ -0,0 +1,103 @@
+#ifndef GT2FIS_MODEL_FILE_H
+#define GT2FIS_MODEL_FILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header of the binary GT2FCM model file, native byte order
+ *
+ * Followed by inputDim normalization divisors and the row-major
+ * numRules x (inputDim+1) UNR table, all double at the given byte offsets.
+ */
+struct GT2FCM_ModelHeader {
+    char magic[8];              // "GT2FCM" + 2 zero bytes
+    uint32_t version;           // GT2FCM_ModelFile::formatVersion
+    uint32_t endianTag;         // 0x01020304 as written by the host
+    uint32_t numRules;
+    uint32_t inputDim;
+    uint32_t numMF;             // MFs the UNR was reduced from, informative only
+    uint32_t reserved;
+    double fcmConstant;
+    uint64_t normOffset;        // byte offset of the normalization divisors
+    uint64_t unrOffset;         // byte offset of the UNR table
+    uint64_t fileSize;
+};
+
+/**
+ * @brief GT2FCM model loaded from disk
+ *
+ * A model is a compact binary file (see GT2FCM_ModelHeader) holding the
+ * precomputed uncertainty rule base UNR and the input normalization, plus a
+ * JSON sidecar with the metadata, e.g. common/gt2fcm_left_foot.json:
+ *
+ *   { "name": ..., "description": ..., "binary": "gt2fcm_left_foot.bin",
+ *     "numRules": 13, "inputDim": 5, "numMF": 7, "fcmConstant": 2.0,
+ *     "inputs": [...], "normalization": [...] }
+ *
+ * The binary is mapped read-only with a single mmap, unr() and normalization()
+ * point into the mapping. Dimensions in the sidecar are checked against the
+ * binary header. Throws std::runtime_error on a missing or inconsistent file.
+ */
+class GT2FCM_ModelFile {
+public:
+    static const uint32_t formatVersion = 1;
+
+    GT2FCM_ModelFile() = default;
+    explicit GT2FCM_ModelFile(const char *path);
+    ~GT2FCM_ModelFile();
+
+    GT2FCM_ModelFile(const GT2FCM_ModelFile &) = delete;
+    GT2FCM_ModelFile &operator=(const GT2FCM_ModelFile &) = delete;
+    GT2FCM_ModelFile(GT2FCM_ModelFile &&other) noexcept;
+    GT2FCM_ModelFile &operator=(GT2FCM_ModelFile &&other) noexcept;
+
+    /**
+     * @brief Load a model, path is the JSON sidecar or the binary itself
+     *
+     * The binary named in the sidecar is resolved relative to the sidecar.
+     */
+    void load(const char *path);
+    void close();
+
+    /**
+     * @brief Write a model as binary plus JSON sidecar
+     *
+     * @param jsonPath Sidecar path, the binary is written next to it with extension .bin
+     * @param unr Row-major numRules x (inputDim+1) UNR table
+     * @param normalization inputDim normalization divisors
+     * @param inputNames Optional names of the inputs, empty or inputDim entries
+     */
+    static void save(const char *jsonPath, const std::string &name, const std::string &description,
+                     const double *unr, const double *normalization,
+                     int numRules, int inputDim, int numMF, double fcmConstant,
+                     const std::vector<std::string> &inputNames = {});
+
+    bool loaded() const { return header != nullptr; }
+    int numRules() const { return static_cast<int>(header->numRules); }
+    int inputDim() const { return static_cast<int>(header->inputDim); }
+    int numMF() const { return static_cast<int>(header->numMF); }
+    double fcmConstant() const { return header->fcmConstant; }
+    const double *unr() const { return unrTable; }                 // numRules x (inputDim+1)
+    const double *normalization() const { return normTable; }      // inputDim divisors
+
+    const std::string &name() const { return modelName; }
+    const std::string &description() const { return modelDescription; }
+    const std::vector<std::string> &inputNames() const { return names; }
+
+private:
+    void *mapping{nullptr};
+    size_t mappingSize{0};
+    const GT2FCM_ModelHeader *header{nullptr};
+    const double *normTable{nullptr};
+    const double *unrTable{nullptr};
+    std::string modelName;
+    std::string modelDescription;
+    std::vector<std::string> names;
+
+    void mapBinary(const std::string &binPath);
+};
+
+#endif // GT2FIS_MODEL_FILE_H
@@ -0,0 +1,411 @@
+#include "IT2FIS_Mamdani.h"
+#include "json/json.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// same as MATLAB trimf, including the value 1 exactly at b
+double trimf(double x, const double *p) {
+    double y = 0.0;
+    if (p[0] != p[1] && p[0] < x && x < p[1])
+        y = (x - p[0]) * (1.0 / (p[1] - p[0]));
+    if (p[1] != p[2] && p[1] < x && x < p[2])
+        y = (p[2] - x) * (1.0 / (p[2] - p[1]));
+    if (x == p[1])
+        y = 1.0;
+    return y;
+}
+
+double upperValue(const IT2TriMF &mf, double x) {
+    return trimf(x, mf.upper);
+}
+
+double lowerValue(const IT2TriMF &mf, double x) {
+    return mf.lowerScale * trimf(x, mf.lower);
+}
+
+IT2TriMF parseMF(const Json::Value &node) {
+    if (node.isMember("type") && node["type"].asString() != "trimf")
+        throw std::runtime_error("IT2MamdaniFIS supports trimf membership functions only");
+    const Json::Value &up = node["upper"];
+    const Json::Value &lo = node["lower"];
+    if (!up.isArray() || up.size() != 3 || !lo.isArray() || lo.size() != 3)
+        throw std::runtime_error("IT2MamdaniFIS membership function needs 3 upper and 3 lower parameters");
+    IT2TriMF mf;
+    for (int i = 0; i < 3; i++) {
+        mf.upper[i] = up[i].asDouble();
+        mf.lower[i] = lo[i].asDouble();
+    }
+    mf.lowerScale = node.get("lowerScale", 1.0).asDouble();
+    return mf;
+}
+
+void checkMethod(const Json::Value &root, const char *key, const char *supported) {
+    if (root.isMember(key) && root[key].asString() != supported)
+        throw std::runtime_error(std::string("IT2MamdaniFIS supports ") + key + " = " + supported + " only");
+}
+
+}
+
+IT2MamdaniFIS::IT2MamdaniFIS(const char *jsonPath) {
+    loadConfig(jsonPath);
+}
+
+void IT2MamdaniFIS::loadConfig(const char *jsonPath) {
+    std::ifstream in(jsonPath, std::ios::binary);
+    if (!in)
+        throw std::runtime_error(std::string("Cannot open FIS config ") + jsonPath);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    loadConfigString(ss.str());
+}
+
+void IT2MamdaniFIS::loadConfigString(const std::string &json) {
+    Json::Reader reader;
+    Json::Value root;
+    if (!reader.parse(json, root))
+        throw std::runtime_error("Cannot parse FIS config: " + reader.getFormattedErrorMessages());
+
+    checkMethod(root, "andMethod", "min");
+    checkMethod(root, "implicationMethod", "min");
+    checkMethod(root, "aggregationMethod", "max");
+    checkMethod(root, "typeReductionMethod", "karnikmendel");
+
+    inputMFs.clear();
+    outputMFs.clear();
+    rules.clear();
+    for (const Json::Value &input : root["inputs"]) {
+        std::vector<IT2TriMF> mfs;
+        for (const Json::Value &mf : input["mfs"])
+            mfs.push_back(parseMF(mf));
+        inputMFs.push_back(mfs);
+    }
+    const Json::Value &output = root["output"];
+    for (const Json::Value &mf : output["mfs"])
+        outputMFs.push_back(parseMF(mf));
+    if (output.isMember("range")) {
+        outMin = output["range"][0].asDouble();
+        outMax = output["range"][1].asDouble();
+    }
+    for (const Json::Value &r : root["rules"]) {
+        Rule rule;
+        for (const Json::Value &idx : r["antecedent"])
+            rule.antecedent.push_back(idx.asInt());
+        rule.consequent = r["consequent"].asInt();
+        rule.weight = r.get("weight", 1.0).asDouble();
+        rules.push_back(rule);
+    }
+    validate();
+
+    mfOffset.assign(inputMFs.size(), 0);
+    int mfNum = 0;
+    for (size_t i = 0; i < inputMFs.size(); i++) {
+        mfOffset[i] = mfNum;
+        mfNum += static_cast<int>(inputMFs[i].size());
+    }
+    muUpper.assign(mfNum, 0.0);
+    muLower.assign(mfNum, 0.0);
+    levelUpper.assign(outputMFs.size(), 0.0);
+    levelLower.assign(outputMFs.size(), 0.0);
+
+    // at most 3 pieces and 5 points per output MF and function, plus one crossing per pair of pieces
+    const size_t maxPieces = 3 * outputMFs.size();
+    const size_t maxPoints = 2 * (5 * outputMFs.size() + maxPieces * maxPieces / 2) + 2;
+    pieces.reserve(maxPieces);
+    pieceOwner.reserve(maxPieces);
+    grid.reserve(maxPoints);
+    for (std::vector<double> *v : {&gridU, &gridL, &cumU0, &cumU1, &cumL0, &cumL1})
+        v->reserve(maxPoints);
+}
+
+void IT2MamdaniFIS::validate() {
+    if (inputMFs.empty() || outputMFs.empty() || rules.empty())
+        throw std::runtime_error("FIS config needs inputs, output membership functions and rules");
+    if (!(outMin < outMax))
+        throw std::runtime_error("FIS output range must be increasing");
+    for (const Rule &rule : rules) {
+        if (rule.antecedent.size() != inputMFs.size())
+            throw std::runtime_error("FIS rule antecedent size does not match number of inputs");
+        for (size_t i = 0; i < inputMFs.size(); i++) {
+            if (rule.antecedent[i] < 0 || rule.antecedent[i] > static_cast<int>(inputMFs[i].size()))
+                throw std::runtime_error("FIS rule antecedent index out of range");
+        }
+        if (rule.consequent < 1 || rule.consequent > static_cast<int>(outputMFs.size()))
+            throw std::runtime_error("FIS rule consequent index out of range");
+    }
+}
+
+bool IT2MamdaniFIS::fire(const double *x) {
+    // input memberships
+    for (size_t i = 0; i < inputMFs.size(); i++) {
+        for (size_t j = 0; j < inputMFs[i].size(); j++) {
+            muUpper[mfOffset[i] + j] = upperValue(inputMFs[i][j], x[i]);
+            muLower[mfOffset[i] + j] = lowerValue(inputMFs[i][j], x[i]);
+        }
+    }
+
+    // firing intervals, rules sharing a consequent only matter through their max
+    std::fill(levelUpper.begin(), levelUpper.end(), 0.0);
+    std::fill(levelLower.begin(), levelLower.end(), 0.0);
+    double sumUpper = 0, sumLower = 0;
+    for (const Rule &rule : rules) {
+        double wu = 1.0, wl = 1.0;
+        for (size_t i = 0; i < rule.antecedent.size(); i++) {
+            if (rule.antecedent[i] == 0)
+                continue;
+            const int idx = mfOffset[i] + rule.antecedent[i] - 1;
+            wu = std::min(wu, muUpper[idx]);
+            wl = std::min(wl, muLower[idx]);
+        }
+        wu *= rule.weight;
+        wl *= rule.weight;
+        sumUpper += wu;
+        sumLower += wl;
+        const int k = rule.consequent - 1;
+        levelUpper[k] = std::max(levelUpper[k], wu);
+        levelLower[k] = std::max(levelLower[k], wl);
+    }
+    yl = yr = 0.5 * (outMin + outMax);
+    return sumUpper != 0.0 || sumLower != 0.0;
+}
+
+double IT2MamdaniFIS::evaluate(const double *x) {
+    const double mid = 0.5 * (outMin + outMax);
+    if (!fire(x))
+        return mid;
+
+    // breakpoints of both aggregated MFs, both are linear between consecutive grid points
+    grid.clear();
+    addBreakpoints(levelUpper.data(), false);
+    addBreakpoints(levelLower.data(), true);
+    grid.push_back(outMin);
+    grid.push_back(outMax);
+    for (double &g : grid)
+        g = std::min(std::max(g, outMin), outMax);
+    std::sort(grid.begin(), grid.end());
+    grid.erase(std::unique(grid.begin(), grid.end()), grid.end());
+
+    const size_t n = grid.size();
+    gridU.resize(n);
+    gridL.resize(n);
+    cumU0.resize(n);
+    cumU1.resize(n);
+    cumL0.resize(n);
+    cumL1.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        gridU[i] = aggregated(grid[i], levelUpper.data(), false);
+        gridL[i] = aggregated(grid[i], levelLower.data(), true);
+    }
+    cumU0[0] = cumU1[0] = cumL0[0] = cumL1[0] = 0.0;
+    for (size_t i = 1; i < n; i++) {
+        const double x0 = grid[i - 1], x1 = grid[i], h = x1 - x0;
+        cumU0[i] = cumU0[i - 1] + 0.5 * h * (gridU[i - 1] + gridU[i]);
+        cumU1[i] = cumU1[i - 1] + h / 6.0 * (gridU[i - 1] * (2 * x0 + x1) + gridU[i] * (x0 + 2 * x1));
+        cumL0[i] = cumL0[i - 1] + 0.5 * h * (gridL[i - 1] + gridL[i]);
+        cumL1[i] = cumL1[i - 1] + h / 6.0 * (gridL[i - 1] * (2 * x0 + x1) + gridL[i] * (x0 + 2 * x1));
+    }
+    if (cumU0[n - 1] <= 0.0)
+        return mid;
+
+    if (cumL0[n - 1] <= 0.0) {
+        // no lower MF, the interval is the support of the upper MF
+        size_t first = 0, last = n - 1;
+        while (first + 1 < n && gridU[first] == 0.0 && gridU[first + 1] == 0.0)
+            first++;
+        while (last > 0 && gridU[last] == 0.0 && gridU[last - 1] == 0.0)
+            last--;
+        yl = grid[first];
+        yr = grid[last];
+    } else {
+        yl = switchPoint(true);
+        yr = switchPoint(false);
+    }
+    return 0.5 * (yl + yr);
+}
+
+double IT2MamdaniFIS::evaluateSampled(const double *x, int sampleNum) {
+    const double mid = 0.5 * (outMin + outMax);
+    if (!fire(x))
+        return mid;
+
+    // samples with a nonzero upper MF, in order
+    std::vector<double> xs, umf, lmf;
+    for (int s = 0; s < sampleNum; s++) {
+        const double xv = outMin + (outMax - outMin) * s / (sampleNum - 1);
+        const double u = aggregated(xv, levelUpper.data(), false);
+        if (u > 0.0) {
+            xs.push_back(xv);
+            umf.push_back(u);
+            lmf.push_back(aggregated(xv, levelLower.data(), true));
+        }
+    }
+    const size_t n = xs.size();
+    if (n == 0)
+        return mid;
+    if (n == 1) {
+        yl = yr = xs[0];
+        return xs[0];
+    }
+    double lowerArea = 0;
+    for (double v : lmf)
+        lowerArea += v;
+    if (lowerArea == 0.0) {
+        yl = xs[0];
+        yr = xs[n - 1];
+        return 0.5 * (yl + yr);
+    }
+
+    auto centroid = [&](const std::vector<double> &mf) {
+        double area = 0, y = 0;
+        for (size_t i = 0; i < n; i++)
+            area += mf[i];
+        if (area == 0.0)
+            return (xs[0] + xs[n - 1]) / 2.0;
+        for (size_t i = 0; i < n; i++)
+            y += xs[i] * mf[i];
+        return y * (1.0 / area);
+    };
+    std::vector<double> mf(n);
+    for (size_t i = 0; i < n; i++)
+        mf[i] = (umf[i] + lmf[i]) * 0.5;
+    const double start = centroid(mf);
+
+    // KM iterations, switch after the sample interval holding the current estimate
+    for (int end = 0; end < 2; end++) {
+        const bool leftEnd = end == 0;
+        double y = start, prev = start + 1.0;
+        while (y != prev) {
+            size_t sw = n - 1;
+            for (size_t i = 0; i + 1 < n; i++) {
+                if (y >= xs[i] && y <= xs[i + 1]) {
+                    sw = i + 1;
+                    break;
+                }
+            }
+            for (size_t i = 0; i < n; i++)
+                mf[i] = (i < sw) == leftEnd ? umf[i] : lmf[i];
+            prev = y;
+            y = centroid(mf);
+            if (leftEnd ? y > prev : y < prev) {
+                y = prev;
+                break;
+            }
+        }
+        (leftEnd ? yl : yr) = y;
+    }
+    return (yl + yr) / 2.0;
+}
+
+void IT2MamdaniFIS::addBreakpoints(const double *levels, bool lowerMF) {
+    pieces.clear();
+    pieceOwner.clear();
+    for (size_t k = 0; k < outputMFs.size(); k++) {
+        const IT2TriMF &mf = outputMFs[k];
+        const double *p = lowerMF ? mf.lower : mf.upper;
+        const double height = lowerMF ? mf.lowerScale : 1.0;
+        const double level = std::min(levels[k], height);
+        if (level <= 0.0)
+            continue;
+        const double a = p[0], b = p[1], c = p[2];
+        double xRise = b, xFall = b;
+        if (b > a) {
+            const double m = height / (b - a);
+            xRise = a + level / m;
+            pieces.push_back({m, -m * a, a, xRise});
+            pieceOwner.push_back(static_cast<int>(k));
+        }
+        if (c > b) {
+            const double m = -height / (c - b);
+            xFall = c + level / m;
+            pieces.push_back({m, -m * c, xFall, c});
+            pieceOwner.push_back(static_cast<int>(k));
+        }
+        if (level < height) {
+            pieces.push_back({0.0, level, xRise, xFall});
+            pieceOwner.push_back(static_cast<int>(k));
+        }
+        grid.push_back(a);
+        grid.push_back(xRise);
+        grid.push_back(b);
+        grid.push_back(xFall);
+        grid.push_back(c);
+    }
+
+    // crossings between pieces of different MFs
+    const double eps = 1e-12;
+    for (size_t i = 0; i < pieces.size(); i++) {
+        for (size_t j = i + 1; j < pieces.size(); j++) {
+            if (pieceOwner[i] == pieceOwner[j] || pieces[i].m == pieces[j].m)
+                continue;
+            const double x = (pieces[j].q - pieces[i].q) / (pieces[i].m - pieces[j].m);
+            if (x >= std::max(pieces[i].x0, pieces[j].x0) - eps && x <= std::min(pieces[i].x1, pieces[j].x1) + eps)
+                grid.push_back(x);
+        }
+    }
+}
+
+double IT2MamdaniFIS::aggregated(double x, const double *levels, bool lowerMF) const {
+    double v = 0.0;
+    for (size_t k = 0; k < outputMFs.size(); k++) {
+        const double mu = lowerMF ? lowerValue(outputMFs[k], x) : upperValue(outputMFs[k], x);
+        v = std::max(v, std::min(mu, levels[k]));
+    }
+    return v;
+}
+
+// KM end point. For the left end the upper MF is used left of the switch point s and
+// the lower MF right of it, for the right end the other way round. With
+// A(s) = integral of the MF, B(s) = integral of x*MF, g(s) = s*A(s) - B(s) has
+// g'(s) = A(s) >= 0 and its root is the centroid with switch point at the centroid,
+// which is the KM fixed point. Inside one segment g is the cubic
+// g0 + A0*t + d0/2*t^2 + k/6*t^3, d0 + k*t the difference of the two MFs.
+double IT2MamdaniFIS::switchPoint(bool leftEnd) const {
+    const size_t n = grid.size();
+    const std::vector<double> &left0 = leftEnd ? cumU0 : cumL0, &left1 = leftEnd ? cumU1 : cumL1;
+    const std::vector<double> &right0 = leftEnd ? cumL0 : cumU0, &right1 = leftEnd ? cumL1 : cumU1;
+    const double total0 = right0[n - 1], total1 = right1[n - 1];
+
+    double gPrev = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double A = left0[i] + total0 - right0[i];
+        const double g = grid[i] * A - (left1[i] + total1 - right1[i]);
+        if (g < 0) {
+            gPrev = g;
+            continue;
+        }
+        if (i == 0)
+            return grid[0];
+
+        const double x0 = grid[i - 1], h = grid[i] - x0;
+        const double A0 = left0[i - 1] + total0 - right0[i - 1];
+        const double d0 = leftEnd ? gridU[i - 1] - gridL[i - 1] : gridL[i - 1] - gridU[i - 1];
+        const double d1 = leftEnd ? gridU[i] - gridL[i] : gridL[i] - gridU[i];
+        const double k = (d1 - d0) / h;
+
+        // safeguarded Newton on [0, h], g(0) < 0 <= g(h)
+        double lo = 0, hi = h;
+        double t = h * (-gPrev) / (g - gPrev);
+        for (int iter = 0; iter < 50; iter++) {
+            const double gt = gPrev + t * (A0 + t * (0.5 * d0 + t * k / 6.0));
+            if (gt < 0)
+                lo = t;
+            else
+                hi = t;
+            const double dg = A0 + t * (d0 + 0.5 * k * t);
+            if (dg > 0 && std::abs(gt) <= 1e-15 * dg * (1.0 + std::abs(x0)))
+                break;
+            double next = dg > 0 ? t - gt / dg : 0.5 * (lo + hi);
+            if (next <= lo || next >= hi)
+                next = 0.5 * (lo + hi);
+            if (hi - lo <= 1e-15 * (1.0 + std::abs(x0)))
+                break;
+            t = next;
+        }
+        return x0 + t;
+    }
+    return grid[n - 1];
+}
@@ -0,0 +1,104 @@
+#ifndef IT2FIS_MAMDANI_H
+#define IT2FIS_MAMDANI_H
+
+#include <vector>
+#include <string>
+
+/**
+ * @brief Interval type-2 triangular membership function
+ *
+ * Upper and lower MF are triangles (a, b, c) evaluated like MATLAB trimf,
+ * the lower MF is multiplied by lowerScale.
+ */
+struct IT2TriMF {
+    double upper[3]{0, 0, 0};
+    double lower[3]{0, 0, 0};
+    double lowerScale{1.0};
+};
+
+/**
+ * @brief Interval type-2 Mamdani fuzzy inference system
+ *
+ * Rules and membership functions are loaded from a JSON config, see
+ * common/stable_contact_fis.json. AND is min, implication min, aggregation max,
+ * type reduction is the Karnik-Mendel centroid and the output is the mean of
+ * the interval ends, as in the MATLAB mamfistype2 the codegen evaluateMyFIS
+ * was generated from.
+ *
+ * Instead of sampling the output universe, the aggregated upper and lower
+ * MFs are kept as piecewise linear functions. Their breakpoints are the MF
+ * vertices, the points where the firing levels clip the MFs and the crossings
+ * between the clipped MFs. Integrals over every segment are exact, the KM
+ * switch point is located on the breakpoints and solved in closed form inside
+ * its segment, so the result is the centroid of the continuous FOU.
+ * No allocation in evaluate() once the config is loaded.
+ */
+class IT2MamdaniFIS {
+public:
+    struct Rule {
+        std::vector<int> antecedent;    // MF index per input, 1-based, 0 means don't care
+        int consequent{1};              // output MF index, 1-based
+        double weight{1.0};
+    };
+
+    IT2MamdaniFIS() = default;
+    explicit IT2MamdaniFIS(const char *jsonPath);
+
+    /**
+     * @brief Load rules and MFs, throws std::runtime_error on a bad config
+     */
+    void loadConfig(const char *jsonPath);
+    void loadConfigString(const std::string &json);
+
+    /**
+     * @brief Crisp output for one input vector of inputNum() values
+     *
+     * Returns the middle of the output range when no rule fires.
+     */
+    double evaluate(const double *x);
+
+    /**
+     * @brief Reference evaluation on sampleNum evenly spaced output samples
+     *
+     * Discrete KM as in the MATLAB toolbox, with 101 samples it reproduces
+     * evaluateMyFIS. Allocates, not meant for the control loop.
+     */
+    double evaluateSampled(const double *x, int sampleNum = 101);
+
+    // type-reduced interval [yl, yr] of the last evaluate()
+    double lastLowerCentroid() const { return yl; }
+    double lastUpperCentroid() const { return yr; }
+
+    bool loaded() const { return !rules.empty(); }
+    int inputNum() const { return static_cast<int>(inputMFs.size()); }
+    int ruleNum() const { return static_cast<int>(rules.size()); }
+
+private:
+    // line y = m*x + q, valid on [x0, x1]
+    struct Piece {
+        double m, q, x0, x1;
+    };
+
+    std::vector<std::vector<IT2TriMF>> inputMFs;
+    std::vector<IT2TriMF> outputMFs;
+    std::vector<Rule> rules;
+    double outMin{0}, outMax{1};
+
+    // scratch, sized in loadConfig
+    std::vector<double> muUpper, muLower;       // per input MF, offset by mfOffset
+    std::vector<int> mfOffset;
+    std::vector<double> levelUpper, levelLower; // per output MF, max firing of its rules
+    std::vector<Piece> pieces;
+    std::vector<int> pieceOwner;
+    std::vector<double> grid, gridU, gridL;
+    std::vector<double> cumU0, cumU1, cumL0, cumL1;   // integrals of f and x*f from outMin to grid[i]
+    double yl{0}, yr{0};
+
+    void validate();
+    bool fire(const double *x);
+    void addBreakpoints(const double *levels, bool lowerMF);
+    double aggregated(double x, const double *levels, bool lowerMF) const;
+    double switchPoint(bool leftEnd) const;
+};
+
+#endif // IT2FIS_MAMDANI_H
@@ -5,38 +5,23 @@ void StableContactDetector::addFrame(bool b_output, const std::array<double, 3>&
     const std::array<double, 3>& angular_vel,
     double contact_probability) {
     if(b_output){
-        // 添加新数据到历史队列
+        // 添加新数据到历史队列，满了覆盖最旧的一帧
         position_history.push_back(position);
-        velocity_history.push_back(velocity);
-        angular_vel_history.push_back(angular_vel);
-        contact_prob_history.push_back(contact_probability);
-
-        // 限制队列大小
-        if (position_history.size() > window_size) {
-            position_history.pop_front();
-            velocity_history.pop_front();
-            angular_vel_history.pop_front();
-            contact_prob_history.pop_front();
-        }
     }
     else{
-        // 添加新数据到历史队列
-        position_history.push_back(position);
-        velocity_history.push_back(velocity);
-        angular_vel_history.push_back(angular_vel);
-        contact_prob_history.push_back(contact_probability);
         // 如果没有接触，则清空历史数据
         position_history.clear();
-        // 限制队列大小
-        if (position_history.size() > window_size) {
-            position_history.pop_front();
-            velocity_history.pop_front();
-            angular_vel_history.pop_front();
-            contact_prob_history.pop_front();
-        }
     }
 }
 
+void StableContactDetector::addWindowSample(double world_horizontal_vel, double world_angular_vel,
+    double contact_probability) {
+    // 速度、角速度、接触概率：无论是否接触都进入窗口
+    horizontal_vel_stats.add(world_horizontal_vel);
+    angular_vel_stats.add(world_angular_vel);
+    contact_prob_stats.add(contact_probability);
+}
+
 //
 std::array<double, 3> StableContactDetector::transformToWorldFrame(
 const std::array<double, 3>& vec, const std::array<double, 3>& rpy) {
@@ -124,4 +109,14 @@ std::array<double, 3> StableContactDetector::calculateWorldTruthVelocity(const s
         world_truth_velocity[2] = 0;
     }
     return world_truth_velocity;
-}
\ No newline at end of file
+}
+
+double StableContactDetector::calculateHorizontalVelocityMagnitude(const std::array<double, 3>& world_vel){
+    return sqrt(world_vel[0]*world_vel[0] + world_vel[1]*world_vel[1]);
+}
+
+double StableContactDetector::calculateAngularVelocityMagnitude(const std::array<double, 3>& world_ang_vel){
+    return sqrt(world_ang_vel[0]*world_ang_vel[0] +
+                world_ang_vel[1]*world_ang_vel[1] +
+                world_ang_vel[2]*world_ang_vel[2]);
+}
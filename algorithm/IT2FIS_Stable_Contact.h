@@ -3,23 +3,24 @@
 
 #include <vector>
 #include <array>
-#include <deque>
 #include <cmath>
 #include <algorithm>
 #include <numeric>
 
+#include "Sliding_Window.h"
+
 // 在DataFilterNormalizer类中添加或在新类StableContactDetector中添加
 class StableContactDetector {
     private:
-        // 历史数据窗口
-        std::deque<std::array<double, 3>> position_history;  // 位置历史
-        std::deque<std::array<double, 3>> velocity_history;  // 速度历史
-        std::deque<std::array<double, 3>> angular_vel_history; // 角速度历史
-        std::deque<double> contact_prob_history;  // 接触概率历史
-        
         // 窗口大小
         size_t window_size;
         double dt = 0.001;
+
+        // 历史数据窗口，容量固定为window_size，每帧O(1)
+        RingBuffer<std::array<double, 3>> position_history;  // 位置历史，仅当前这段接触内，无接触时清空
+        SlidingWindowStats horizontal_vel_stats;  // 水平速度大小，最近window_size帧
+        SlidingWindowStats angular_vel_stats;     // 角速度大小，最近window_size帧
+        SlidingWindowStats contact_prob_stats;    // 接触概率，最近window_size帧
         
         // 归一化参数
         double max_horizontal_disp;
@@ -29,17 +30,26 @@ class StableContactDetector {
     public:
         StableContactDetector(size_t window_size = 50) : 
             window_size(window_size),
+            position_history(window_size),
+            horizontal_vel_stats(window_size),
+            angular_vel_stats(window_size),
+            contact_prob_stats(window_size),
             max_horizontal_disp(0.3),
             max_horizontal_vel(1.0),
             max_angular_vel(10.0) {
             // 初始化
         }
         
-        // 添加当前帧数据
+        // 添加当前帧数据，只更新位置历史（水平位移）
         void addFrame(bool b_output, const std::array<double, 3>& position, 
                      const std::array<double, 3>& velocity,
                      const std::array<double, 3>& angular_vel,
                      double contact_probability);
+
+        // 窗口统计的输入，需要均值/极值时才调用（ContactEstimator不调用）
+        // 速度为世界坐标系下的大小，与ContactEstimator的h_velocity/ang_velocity相同：
+        // calculateHorizontalVelocityMagnitude(transformToWorldFrame(velocity, rpy))
+        void addWindowSample(double world_horizontal_vel, double world_angular_vel, double contact_probability);
                      
         
         // 世界坐标系转换
@@ -56,6 +66,16 @@ class StableContactDetector {
         
         // 计算角速度大小
         double calculateAngularVelocityMagnitude(const std::array<double, 3>& world_ang_vel);
+
+        // 窗口统计，最近window_size次addWindowSample
+        double meanHorizontalVelocity() const { return horizontal_vel_stats.mean(); }
+        double maxHorizontalVelocity() const { return horizontal_vel_stats.max(); }
+        double meanAngularVelocity() const { return angular_vel_stats.mean(); }
+        double maxAngularVelocity() const { return angular_vel_stats.max(); }
+        double meanContactProbability() const { return contact_prob_stats.mean(); }
+        double minContactProbability() const { return contact_prob_stats.min(); }
+        // 当前这段接触在窗口内的帧数
+        size_t contactFrames() const { return position_history.size(); }
     };
 
 
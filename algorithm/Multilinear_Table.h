@@ -0,0 +1,189 @@
+#ifndef MULTILINEAR_TABLE_H
+#define MULTILINEAR_TABLE_H
+
+#include <array>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+/**
+ * @brief Function of Dim inputs tabulated on a regular grid
+ *
+ * build() samples the function on pointsPerAxis points per axis of the box
+ * [lo, hi], operator() interpolates multilinearly between the 2^Dim
+ * surrounding grid points. Inputs outside the box are clamped to it.
+ * Values are stored row-major with the last axis contiguous; with T = float
+ * a 5-D table with 9 points per axis takes 236 kB.
+ *
+ * measureError() compares the table with the exact function at all cell
+ * centres (where multilinear interpolation error peaks for smooth functions)
+ * and at random points. It is an empirical bound, a function with features
+ * smaller than a cell can exceed it between the tested points.
+ *
+ * @tparam Dim Input dimension
+ * @tparam T   Storage type of the tabulated values
+ */
+template<int Dim, typename T = float>
+class MultilinearTable {
+public:
+    static constexpr int corners = 1 << Dim;
+
+    struct Error {
+        double max{0};          // max |table - exact| over the tested points
+        double mean{0};
+        size_t points{0};       // number of tested points
+    };
+
+    MultilinearTable() = default;
+
+    /**
+     * @brief Tabulate func on the box [lo, hi]
+     *
+     * @param pointsPerAxis Grid resolution, at least 2
+     * @param func Callable double(const double* x) with Dim inputs
+     */
+    template<typename Func>
+    void build(int pointsPerAxis, const std::array<double, Dim>& lo, const std::array<double, Dim>& hi, Func&& func) {
+        if (pointsPerAxis < 2) {
+            throw std::invalid_argument("MultilinearTable needs at least 2 points per axis");
+        }
+        n = pointsPerAxis;
+        lower = lo;
+        size_t total = 1;
+        for (int k = Dim - 1; k >= 0; k--) {
+            if (!(hi[k] > lo[k])) {
+                throw std::invalid_argument("MultilinearTable box must have hi > lo");
+            }
+            step[k] = (hi[k] - lo[k]) / (n - 1);
+            invStep[k] = 1.0 / step[k];
+            stride[k] = total;
+            total *= n;
+        }
+        values.resize(total);
+
+        std::array<int, Dim> idx{};
+        double x[Dim];
+        for (size_t i = 0; i < total; i++) {
+            for (int k = 0; k < Dim; k++) {
+                x[k] = (idx[k] == n - 1) ? hi[k] : lower[k] + idx[k] * step[k];
+            }
+            values[i] = static_cast<T>(func(static_cast<const double*>(x)));
+            for (int k = Dim - 1; k >= 0 && ++idx[k] == n; k--) {
+                idx[k] = 0;
+            }
+        }
+        upper = hi;
+    }
+
+    /**
+     * @brief Interpolated value at x, Dim inputs
+     */
+    double operator()(const double* x) const {
+        size_t base = 0;
+        double t[Dim];
+        for (int k = 0; k < Dim; k++) {
+            double u = (x[k] - lower[k]) * invStep[k];
+            u = std::min(std::max(u, 0.0), static_cast<double>(n - 1));
+            int i = std::min(static_cast<int>(u), n - 2);
+            t[k] = u - i;
+            base += i * stride[k];
+        }
+
+        // gather the corners, bit k of the corner index selects the upper point on axis k
+        double c[corners];
+        for (int j = 0; j < corners; j++) {
+            size_t offset = base;
+            for (int k = 0; k < Dim; k++) {
+                if (j & (1 << k)) offset += stride[k];
+            }
+            c[j] = values[offset];
+        }
+        // reduce one axis at a time, the highest axis pairs are half the array apart
+        for (int k = Dim - 1; k >= 0; k--) {
+            const int half = 1 << k;
+            for (int j = 0; j < half; j++) {
+                c[j] += t[k] * (c[j + half] - c[j]);
+            }
+        }
+        return c[0];
+    }
+
+    double operator()(const std::array<double, Dim>& x) const { return (*this)(x.data()); }
+
+    /**
+     * @brief Compare with the exact function at cell centres and random points
+     *
+     * @param func The tabulated function
+     * @param randomPoints Number of uniformly distributed random points
+     * @param maxCentres Cell centres are all tested up to this count, otherwise randomly chosen ones
+     */
+    template<typename Func>
+    Error measureError(Func&& func, size_t randomPoints = 100000, size_t maxCentres = 1000000, unsigned seed = 1) const {
+        Error err;
+        if (values.empty()) {
+            return err;
+        }
+        double sum = 0;
+        double x[Dim];
+        auto test = [&]() {
+            double e = std::abs((*this)(x) - func(static_cast<const double*>(x)));
+            err.max = std::max(err.max, e);
+            sum += e;
+            err.points++;
+        };
+
+        std::mt19937 gen(seed);
+        size_t cells = 1;
+        for (int k = 0; k < Dim; k++) {
+            cells *= n - 1;
+        }
+        if (cells <= maxCentres) {
+            std::array<int, Dim> idx{};
+            for (size_t i = 0; i < cells; i++) {
+                for (int k = 0; k < Dim; k++) {
+                    x[k] = lower[k] + (idx[k] + 0.5) * step[k];
+                }
+                test();
+                for (int k = Dim - 1; k >= 0 && ++idx[k] == n - 1; k--) {
+                    idx[k] = 0;
+                }
+            }
+        } else {
+            std::uniform_int_distribution<int> cell(0, n - 2);
+            for (size_t i = 0; i < maxCentres; i++) {
+                for (int k = 0; k < Dim; k++) {
+                    x[k] = lower[k] + (cell(gen) + 0.5) * step[k];
+                }
+                test();
+            }
+        }
+
+        for (size_t i = 0; i < randomPoints; i++) {
+            for (int k = 0; k < Dim; k++) {
+                x[k] = std::uniform_real_distribution<double>(lower[k], upper[k])(gen);
+            }
+            test();
+        }
+        err.mean = sum / err.points;
+        return err;
+    }
+
+    bool empty() const { return values.empty(); }
+    void clear() { values.clear(); values.shrink_to_fit(); }
+    int resolution() const { return n; }
+    size_t memoryBytes() const { return values.size() * sizeof(T); }
+
+private:
+    std::vector<T> values;
+    std::array<double, Dim> lower{};
+    std::array<double, Dim> upper{};
+    std::array<double, Dim> step{};
+    std::array<double, Dim> invStep{};
+    std::array<size_t, Dim> stride{};
+    int n{0};
+};
+
+#endif // MULTILINEAR_TABLE_H
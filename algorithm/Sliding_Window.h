@@ -0,0 +1,380 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <array>
+#include <algorithm>
+
+/**
+ * @brief Fixed-capacity ring buffer
+ *
+ * Storage is allocated once in the constructor. push_back() on a full buffer
+ * overwrites the oldest element, so it can be used directly as a sliding window.
+ * Index 0 is the oldest element.
+ */
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : buf(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("RingBuffer capacity must be positive");
+        }
+    }
+
+    void push_back(const T& v) {
+        buf[(head + count) % buf.size()] = v;
+        if (count < buf.size()) {
+            count++;
+        } else {
+            head = (head + 1) % buf.size();
+        }
+    }
+
+    void pop_front() {
+        head = (head + 1) % buf.size();
+        count--;
+    }
+
+    void pop_back() { count--; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    const T& front() const { return buf[head]; }
+    const T& back() const { return buf[(head + count - 1) % buf.size()]; }
+    const T& operator[](size_t i) const { return buf[(head + i) % buf.size()]; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return buf.size(); }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == buf.size(); }
+
+private:
+    std::vector<T> buf;
+    size_t head{0};     // index of the oldest element
+    size_t count{0};
+};
+
+/**
+ * @brief Sum, mean, min and max over the last window samples in O(1) per sample
+ *
+ * The sum is kept as a running sum and recomputed from the window once every
+ * window samples, so rounding errors do not accumulate. Min and max use
+ * monotonic queues of (sample index, value).
+ */
+class SlidingWindowStats {
+public:
+    explicit SlidingWindowStats(size_t window)
+        : values(window), minQueue(window), maxQueue(window) {}
+
+    void add(double v) {
+        if (values.full()) {
+            runningSum -= values.front();
+        }
+        values.push_back(v);
+        runningSum += v;
+        if (++sinceResum >= values.capacity()) {
+            runningSum = 0.0;
+            for (size_t i = 0; i < values.size(); i++) {
+                runningSum += values[i];
+            }
+            sinceResum = 0;
+        }
+
+        // drop samples that left the window, then the ones dominated by v
+        const size_t window = values.capacity();
+        while (!minQueue.empty() && minQueue.front().first + window <= sampleIdx) minQueue.pop_front();
+        while (!maxQueue.empty() && maxQueue.front().first + window <= sampleIdx) maxQueue.pop_front();
+        while (!minQueue.empty() && minQueue.back().second >= v) minQueue.pop_back();
+        while (!maxQueue.empty() && maxQueue.back().second <= v) maxQueue.pop_back();
+        minQueue.push_back({sampleIdx, v});
+        maxQueue.push_back({sampleIdx, v});
+        sampleIdx++;
+    }
+
+    void clear() {
+        values.clear();
+        minQueue.clear();
+        maxQueue.clear();
+        runningSum = 0.0;
+        sinceResum = 0;
+    }
+
+    size_t size() const { return values.size(); }
+    double sum() const { return runningSum; }
+    double mean() const { return values.empty() ? 0.0 : runningSum / values.size(); }
+    double min() const { return minQueue.empty() ? 0.0 : minQueue.front().second; }
+    double max() const { return maxQueue.empty() ? 0.0 : maxQueue.front().second; }
+
+private:
+    RingBuffer<double> values;
+    RingBuffer<std::pair<uint64_t, double>> minQueue;   // increasing values
+    RingBuffer<std::pair<uint64_t, double>> maxQueue;   // decreasing values
+    double runningSum{0.0};
+    size_t sinceResum{0};
+    uint64_t sampleIdx{0};
+};
+
+/**
+ * @brief Median over the last window samples in O(log window) per sample
+ *
+ * Samples live in a ring of slots. A max-heap holds the lower half and a
+ * min-heap the upper half, both store slot indices and every slot knows its
+ * heap position, so the sample leaving the window is removed in place.
+ * For an even count the median is the mean of the two middle values, same as
+ * sorting the window.
+ */
+class StreamingMedian {
+public:
+    explicit StreamingMedian(size_t window)
+        : values(window), heapPos(window), inLow(window) {
+        if (window == 0) {
+            throw std::invalid_argument("StreamingMedian window must be positive");
+        }
+        low.reserve(window);
+        high.reserve(window);
+    }
+
+    // add a sample and return the median of the window
+    double add(double v) {
+        const size_t window = values.size();
+        size_t slot;
+        if (count < window) {
+            slot = (head + count) % window;
+            count++;
+        } else {
+            slot = head;
+            head = (head + 1) % window;
+            remove(slot);
+        }
+        values[slot] = v;
+        insert(slot);
+        return median();
+    }
+
+    double median() const {
+        if (count == 0)
+            return 0.0;
+        if (count % 2 == 0)
+            return (values[low[0]] + values[high[0]]) / 2.0;
+        return values[low[0]];
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        low.clear();
+        high.clear();
+    }
+
+    size_t size() const { return count; }
+
+private:
+    std::vector<double> values;     // by slot
+    std::vector<size_t> heapPos;    // by slot, index in low or high
+    std::vector<char> inLow;        // by slot
+    std::vector<size_t> low;        // max-heap of slots, lower half, size is count/2 rounded up
+    std::vector<size_t> high;       // min-heap of slots, upper half
+    size_t head{0};                 // oldest slot
+    size_t count{0};
+
+    // a should be above b in the heap
+    bool before(bool isLow, size_t a, size_t b) const {
+        return isLow ? values[a] > values[b] : values[a] < values[b];
+    }
+
+    void place(bool isLow, size_t idx, size_t slot) {
+        (isLow ? low : high)[idx] = slot;
+        heapPos[slot] = idx;
+        inLow[slot] = isLow;
+    }
+
+    void siftUp(bool isLow, size_t idx) {
+        std::vector<size_t>& heap = isLow ? low : high;
+        size_t slot = heap[idx];
+        while (idx > 0) {
+            size_t parent = (idx - 1) / 2;
+            if (!before(isLow, slot, heap[parent]))
+                break;
+            place(isLow, idx, heap[parent]);
+            idx = parent;
+        }
+        place(isLow, idx, slot);
+    }
+
+    void siftDown(bool isLow, size_t idx) {
+        std::vector<size_t>& heap = isLow ? low : high;
+        size_t slot = heap[idx];
+        const size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * idx + 1;
+            if (child >= n)
+                break;
+            if (child + 1 < n && before(isLow, heap[child + 1], heap[child]))
+                child++;
+            if (!before(isLow, heap[child], slot))
+                break;
+            place(isLow, idx, heap[child]);
+            idx = child;
+        }
+        place(isLow, idx, slot);
+    }
+
+    void push(bool isLow, size_t slot) {
+        std::vector<size_t>& heap = isLow ? low : high;
+        heap.push_back(slot);
+        heapPos[slot] = heap.size() - 1;
+        inLow[slot] = isLow;
+        siftUp(isLow, heap.size() - 1);
+    }
+
+    size_t pop(bool isLow) {
+        std::vector<size_t>& heap = isLow ? low : high;
+        size_t top = heap[0];
+        size_t last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            place(isLow, 0, last);
+            siftDown(isLow, 0);
+        }
+        return top;
+    }
+
+    void remove(size_t slot) {
+        bool isLow = inLow[slot];
+        std::vector<size_t>& heap = isLow ? low : high;
+        size_t idx = heapPos[slot];
+        size_t last = heap.back();
+        heap.pop_back();
+        if (idx < heap.size()) {
+            place(isLow, idx, last);
+            siftUp(isLow, idx);
+            siftDown(isLow, heapPos[last]);
+        }
+    }
+
+    void insert(size_t slot) {
+        push(low.empty() || values[slot] <= values[low[0]], slot);
+        // keep low.size() == high.size() or high.size() + 1
+        if (low.size() > high.size() + 1) {
+            push(false, pop(true));
+        } else if (high.size() > low.size()) {
+            push(true, pop(false));
+        }
+    }
+};
+
+/**
+ * @brief Running p-quantile of an unbounded stream in O(1) memory (P-square algorithm)
+ *
+ * Jain & Chlamtac: five markers track the minimum, p/2, p, (1+p)/2 quantiles and the
+ * maximum. Marker heights are moved by piecewise-parabolic interpolation whenever a
+ * marker position drifts more than one sample from its desired position. Below five
+ * samples the quantile is taken from the sorted samples. The whole state is a few
+ * numbers, state()/restore() copy it for persistence.
+ */
+class P2Quantile {
+public:
+    struct State {
+        double p{0.5};
+        uint64_t count{0};
+        std::array<double, 5> height{};     // marker heights, the first count samples below five
+        std::array<double, 5> position{};   // marker positions, 1-based
+        std::array<double, 5> desired{};    // desired marker positions
+    };
+
+    explicit P2Quantile(double p = 0.5) {
+        if (!(p > 0.0 && p < 1.0)) {
+            throw std::invalid_argument("P2Quantile p must be in (0, 1)");
+        }
+        st.p = p;
+    }
+
+    void add(double x) {
+        std::array<double, 5>& h = st.height;
+        std::array<double, 5>& n = st.position;
+        if (st.count < 5) {
+            h[st.count++] = x;
+            if (st.count == 5) {
+                std::sort(h.begin(), h.end());
+                n = {1.0, 2.0, 3.0, 4.0, 5.0};
+                st.desired = {1.0, 1.0 + 2.0 * st.p, 1.0 + 4.0 * st.p, 3.0 + 2.0 * st.p, 5.0};
+            }
+            return;
+        }
+
+        // cell of x, extremes are replaced
+        int k;
+        if (x < h[0]) {
+            h[0] = x;
+            k = 0;
+        } else if (x >= h[4]) {
+            h[4] = std::max(h[4], x);
+            k = 3;
+        } else {
+            k = 0;
+            while (x >= h[k + 1]) {
+                k++;
+            }
+        }
+        for (int i = k + 1; i < 5; i++) {
+            n[i] += 1.0;
+        }
+        const double increment[5] = {0.0, st.p / 2.0, st.p, (1.0 + st.p) / 2.0, 1.0};
+        for (int i = 0; i < 5; i++) {
+            st.desired[i] += increment[i];
+        }
+        st.count++;
+
+        for (int i = 1; i < 4; i++) {
+            const double d = st.desired[i] - n[i];
+            if ((d >= 1.0 && n[i + 1] - n[i] > 1.0) || (d <= -1.0 && n[i - 1] - n[i] < -1.0)) {
+                const int s = d > 0.0 ? 1 : -1;
+                const double parabolic = h[i] + s / (n[i + 1] - n[i - 1]) *
+                    ((n[i] - n[i - 1] + s) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+                     (n[i + 1] - n[i] - s) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+                if (h[i - 1] < parabolic && parabolic < h[i + 1]) {
+                    h[i] = parabolic;
+                } else {
+                    h[i] += s * (h[i + s] - h[i]) / (n[i + s] - n[i]);
+                }
+                n[i] += s;
+            }
+        }
+    }
+
+    double value() const {
+        if (st.count >= 5) {
+            return st.height[2];
+        }
+        if (st.count == 0) {
+            return 0.0;
+        }
+        std::array<double, 5> sorted = st.height;
+        std::sort(sorted.begin(), sorted.begin() + st.count);
+        return sorted[static_cast<size_t>(st.p * (st.count - 1) + 0.5)];
+    }
+
+    uint64_t count() const { return st.count; }
+    double quantile() const { return st.p; }
+    void clear() { st = State{st.p}; }
+
+    const State& state() const { return st; }
+    void restore(const State& state) {
+        if (!(state.p > 0.0 && state.p < 1.0)) {
+            throw std::invalid_argument("P2Quantile p must be in (0, 1)");
+        }
+        st = state;
+    }
+
+private:
+    State st;
+};
+
+#endif // SLIDING_WINDOW_H
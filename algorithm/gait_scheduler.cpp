@@ -42,6 +42,9 @@ void GaitScheduler::dataBusRead(const DataBus &robotState) {
     fe_r_rot_W=robotState.fe_r_rot_W;
     dq=robotState.dq;
     motionState=robotState.motionState;
+    contactEstValid=robotState.contactEstValid;
+    fLcontactEst=robotState.fLcontactEst;
+    fRcontactEst=robotState.fRcontactEst;
 }
 
 void GaitScheduler::dataBusWrite(DataBus &robotState) {
@@ -114,7 +117,15 @@ void GaitScheduler::step() {
         }
     }
 
-    if (legState == DataBus::LSt && FRest[2] >= FzThrehold && phi>=0.6){
+    // touch-down of the swing foot, from the estimated contact force or from the contact estimator
+    bool touchL = FLest[2] >= FzThrehold;
+    bool touchR = FRest[2] >= FzThrehold;
+    if (useContactEst && contactEstValid) {
+        touchL = fLcontactEst;
+        touchR = fRcontactEst;
+    }
+
+    if (legState == DataBus::LSt && touchR && phi>=0.6){
         if (enableNextStep){
             legState = DataBus::RSt;
             swingStartPos_W=fe_l_pos_W;
@@ -122,7 +133,7 @@ void GaitScheduler::step() {
             phi=0;
         }
     }
-    else if(legState == DataBus::RSt && FLest[2] >= FzThrehold && phi>=0.6){
+    else if(legState == DataBus::RSt && touchL && phi>=0.6){
         if (enableNextStep) {
             legState = DataBus::LSt;
             swingStartPos_W = fe_r_pos_W;
@@ -19,6 +19,7 @@ public:
     double dt{0.001};
     double FzThrehold{100};
     double Fz_L_m{0}, Fz_R_m{0};
+    bool useContactEst{false}; // use the estimated foot contact (DataBus::f*contactEst) instead of FzThrehold for touch-down
     DataBus::LegState legState, legStateNext;
     DataBus::MotionState motionState;
     GaitScheduler(double tSwingIn, double dtIn);
@@ -38,6 +39,8 @@ private:
     Eigen::MatrixXd dyn_M, dyn_Non, J_l, J_r, dJ_l, dJ_r;
     double theta0;
     int model_nv;
+    bool contactEstValid{false};
+    bool fLcontactEst{false}, fRcontactEst{false};
 
 };
 
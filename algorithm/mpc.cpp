@@ -7,6 +7,7 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
 */
 #include "mpc.h"
 #include "useful_math.h"
+#include <algorithm>
 
 
 MPC::MPC(double dtIn):QP(nu*ch, nc*ch) {
@@ -35,8 +36,6 @@ MPC::MPC(double dtIn):QP(nu*ch, nc*ch) {
     C.setZero();
 
     Aqp.setZero();
-    Aqp1.setZero();
-    Bqp1.setZero();
     Bqp.setZero();
     Cqp1.setZero();
     Cqp.setZero();
@@ -54,6 +53,7 @@ MPC::MPC(double dtIn):QP(nu*ch, nc*ch) {
     alpha = 0.0;
     H.setZero();
     c.setZero();
+    delta_U.setZero();
 
     u_low.setZero(); u_up.setZero();
     As.setZero();
@@ -69,6 +69,14 @@ MPC::MPC(double dtIn):QP(nu*ch, nc*ch) {
     QP.setOptions(option);
 
     dt = dtIn;
+
+    // constant blocks of the model, cal() only updates the ones depending on R_curz and pf2com
+    for (int i = 0; i < mpc_N; i++) {
+        Ac[i].block<3, 3>(3, 9) = Eigen::Matrix3d::Identity();
+        Bc[i].block<3, 3>(9, 0) = Eigen::Matrix3d::Identity() / m;
+        Bc[i].block<3, 3>(9, 6) = Eigen::Matrix3d::Identity() / m;
+        Bc[i]((nx - 1), (nu - 1)) = 1.0 / m;
+    }
 }
 
 void MPC::set_weight(double u_weight, Eigen::MatrixXd L_diag, Eigen::MatrixXd K_diag) {
@@ -192,68 +200,71 @@ void MPC::dataBusRead(DataBus &Data) {
     R_w2f = R_f2w.transpose();
 }
 
+// A[i] = I + dt*Ac[i] where Ac[i] only has the blocks (0,6) and (3,9): A[i]*X only changes rows 0..5 of X
+static void applyA(const Eigen::Matrix<double, nx, nx> &A, Eigen::Ref<Eigen::MatrixXd> X) {
+    X.topRows(3).noalias() += A.block<3, 3>(0, 6) * X.middleRows(6, 3);
+    X.middleRows(3, 3).noalias() += A.block<3, 3>(3, 9) * X.middleRows(9, 3);
+}
+
+void MPC::updatePrediction() {
+    const Eigen::Matrix3d Ic_inv = Ic.inverse();
+    for (int i = 0; i < mpc_N; i++) {
+        Ac[i].block<3, 3>(0, 6) = R_curz[i].transpose();
+        A[i] = Eigen::Matrix<double, nx, nx>::Identity() + dt * Ac[i];
+
+        pf2comi[i] = pf2com;
+        const Eigen::Matrix3d Ic_W_inv = R_curz[i] * Ic_inv * R_curz[i].transpose();
+        Bc[i].block<3, 3>(6, 0) = Ic_W_inv * CrossProduct_A(pf2comi[i].block<3, 1>(0, 0));
+        Bc[i].block<3, 3>(6, 3) = Ic_W_inv;
+        Bc[i].block<3, 3>(6, 6) = Ic_W_inv * CrossProduct_A(pf2comi[i].block<3, 1>(3, 0));
+        Bc[i].block<3, 3>(6, 9) = Ic_W_inv;
+        B[i] = dt * Bc[i];
+    }
+
+    // one pass over the horizon: Aqp_i = A[i]*Aqp_i-1, Bqp_i = A[i]*Bqp_i-1 + B[i] in the input block of step i,
+    // input blocks after step i are still zero and skipped
+    Bqp.setZero();
+    for (int i = 0; i < mpc_N; i++) {
+        const int used = std::min(i, ch - 1) + 1;
+        if (i == 0)
+            Aqp.block<nx, nx>(0, 0).setIdentity();
+        else {
+            Aqp.block<nx, nx>(i * nx, 0) = Aqp.block<nx, nx>((i - 1) * nx, 0);
+            Bqp.block(i * nx, 0, nx, nu * used) = Bqp.block((i - 1) * nx, 0, nx, nu * used);
+        }
+        applyA(A[i], Aqp.block<nx, nx>(i * nx, 0));
+        applyA(A[i], Bqp.block(i * nx, 0, nx, nu * used));
+        Bqp.block<nx, nu>(i * nx, nu * (used - 1)) += B[i];
+    }
+
+    delta_U.setZero();
+    for (int i = 0; i < ch; i++){
+        if (legState[i] == DataBus::LSt)
+            delta_U(nu*i + 2) = m*g;
+        else if (legState[i] == DataBus::RSt)
+            delta_U(nu*i + 8) = m*g;
+        else{
+            delta_U(nu*i + 2) = 0.5*m*g;
+            delta_U(nu*i + 8) = 0.5*m*g;
+        }
+    }
+
+    // L is block diagonal (set_weight), Bqp'*L*Bqp and Bqp'*L*(Aqp*X_cur - Xd) are summed step by step
+    H.setZero();
+    c.setZero();
+    for (int i = 0; i < mpc_N; i++) {
+        const Eigen::Matrix<double, nx, nu * ch> LB = L.block<nx, nx>(i * nx, i * nx) * Bqp.block<nx, nu * ch>(i * nx, 0);
+        H.noalias() += Bqp.block<nx, nu * ch>(i * nx, 0).transpose() * LB;
+        c.noalias() += LB.transpose() * (Aqp.block<nx, nx>(i * nx, 0) * X_cur - Xd.block<nx, 1>(i * nx, 0));
+    }
+    H = 2 * (H + alpha * K) + 1e-10 * Eigen::Matrix<double, nu * ch, nu * ch>::Identity();
+    c = 2 * c + 2 * alpha * K * delta_U;
+}
+
 void MPC::cal() {
     if (EN) {
         //qp pre
-		for (int i = 0; i < mpc_N; i++) {
-			Ac[i].block<3, 3>(0, 6) = R_curz[i].transpose();
-			Ac[i].block<3, 3>(3, 9) = Eigen::MatrixXd::Identity(3,3);
-			A[i] = Eigen::MatrixXd::Identity(nx,nx) + dt * Ac[i];
-		}
-		for (int i = 0; i < mpc_N; i++) {
-			pf2comi[i] = pf2com;
-			Eigen::Matrix3d Ic_W_inv;
-			Ic_W_inv = (R_curz[i] * Ic * R_curz[i].transpose()).inverse();
-			Bc[i].block<3, 3>(6, 0) = Ic_W_inv * CrossProduct_A(pf2comi[i].block<3, 1>(0, 0));
-			Bc[i].block<3, 3>(6, 3) = Ic_W_inv;
-			Bc[i].block<3, 3>(6, 6) = Ic_W_inv * CrossProduct_A(pf2comi[i].block<3, 1>(3, 0));
-			Bc[i].block<3, 3>(6, 9) = Ic_W_inv;
-			Bc[i].block<3, 3>(9, 0) = Eigen::MatrixXd::Identity(3,3)/ m;
-			Bc[i].block<3, 3>(9, 6) = Eigen::MatrixXd::Identity(3,3)/ m;
-			Bc[i]((nx - 1), (nu - 1)) = 1.0 / m;
-			B[i] = dt * Bc[i];
-		}
-		for (int i = 0; i < mpc_N; i++)
-			Aqp.block<nx, nx>(i * nx, 0) = Eigen::MatrixXd::Identity(nx,nx);
-		for (int i = 0; i < mpc_N; i++)
-			for (int j = 0; j < i + 1; j++)
-				Aqp.block<nx, nx>(i * nx, 0) = A[j] * Aqp.block<nx, nx>(i * nx, 0);
-
-		for (int i = 0; i < mpc_N; i++)
-			for (int j = 0; j < i + 1; j++)
-				Aqp1.block<nx, nx>(i * nx, j * nx) = Eigen::MatrixXd::Identity(nx,nx);
-        for (int i = 1; i < mpc_N; i++)
-            for (int j = 0; j < i; j++)
-                for (int k = j + 1; k < (i + 1); k++)
-                    Aqp1.block<nx, nx>(i * nx, j * nx) = A[k] * Aqp1.block<nx, nx>(i * nx, j * nx);
-
-        for (int i = 0; i < mpc_N; i++)
-            Bqp1.block<nx, nu>(i * nx, i * nu) = B[i];
-        Eigen::MatrixXd Bqp11 = Eigen::MatrixXd::Zero(nu * mpc_N, nu * ch);
-        Bqp11.setZero();
-        Bqp11.block<nu * ch, nu * ch>(0, 0) = Eigen::MatrixXd::Identity(nu * ch, nu * ch);
-        for (int i = 0; i < (mpc_N - ch); i++)
-            Bqp11.block<nu, nu>(nu * ch + i * nu, nu * (ch - 1)) = Eigen::MatrixXd::Identity(nu, nu);
-
-        Eigen::MatrixXd B_tmp = Eigen::MatrixXd::Zero(nx * mpc_N, nu * ch);
-        B_tmp = Bqp1 * Bqp11;
-        Bqp = Aqp1 * B_tmp;
-
-		Eigen::Matrix<double, nu*ch, 1>		delta_U;
-		delta_U.setZero();
-		for (int i = 0; i < ch; i++){
-			if (legState[i] == DataBus::LSt)
-				delta_U(nu*i + 2) = m*g;
-			else if (legState[i] == DataBus::RSt)
-				delta_U(nu*i + 8) = m*g;
-			else{
-				delta_U(nu*i + 2) = 0.5*m*g;
-				delta_U(nu*i + 8) = 0.5*m*g;
-			}
-		}
-
-		H = 2 * (Bqp.transpose() * L * Bqp + alpha * K) + 1e-10*Eigen::MatrixXd::Identity(nx*mpc_N, nx*mpc_N);
-		c = 2 * Bqp.transpose() * L * (Aqp * X_cur - Xd) + 2 * alpha * K * delta_U;
+        updatePrediction();
 
         //friction constraint
         Eigen::Matrix<double, ncfr_single, 3> Asfr111, Asfr11;
@@ -456,7 +467,7 @@ void MPC::cal() {
             delta_X(i+9) = dX_cal(i+9)*dt;
         }
 
-        X_cal = (Aqp * X_cur + Bqp * Ufe).block<nx,1>(nx*0,0) + delta_X;
+        X_cal = Aqp.block<nx, nx>(0, 0) * X_cur + Bqp.block<nx, nu * ch>(0, 0) * Ufe + delta_X;
 
         Ufe_pre = Ufe.block<nu, 1>(0, 0);
         QP.reset();
@@ -34,7 +34,13 @@ public:
     MPC(double dtIn);
 
     void    set_weight(double u_weight, Eigen::MatrixXd L_diag, Eigen::MatrixXd K_diag);
-    void    cal();
+    void    cal();              // updatePrediction(), then the constraints and the QP solve
+    void    updatePrediction(); // condensed prediction Aqp, Bqp and the QP cost H, c for the current state
+
+    const Eigen::Matrix<double,nx*mpc_N,nx>     &get_Aqp() const {return Aqp;}
+    const Eigen::Matrix<double,nx*mpc_N,nu*ch>  &get_Bqp() const {return Bqp;}
+    const Eigen::Matrix<double,nu*ch, nu*ch>    &get_H() const {return H;}
+    const Eigen::Matrix<double,nu*ch, 1>        &get_c() const {return c;}
     void    dataBusRead(DataBus &Data);
     void    dataBusWrite(DataBus &Data);
 
@@ -52,9 +58,8 @@ private:
     Eigen::Matrix<double,nx,nu>   Bc[mpc_N], B[mpc_N];
     Eigen::Matrix<double,nx,1>    Cc, C;
 
+    // X = Aqp*X_cur + Bqp*U over the horizon, the last input block is held from step ch-1 on
     Eigen::Matrix<double,nx*mpc_N,nx>         Aqp;
-    Eigen::Matrix<double,nx*mpc_N,nx*mpc_N>   Aqp1;
-    Eigen::Matrix<double,nx*mpc_N,nu*mpc_N>   Bqp1;
     Eigen::Matrix<double,nx*mpc_N,nu*ch>      Bqp;
     Eigen::Matrix<double,nx*mpc_N,1>          Cqp1;
     Eigen::Matrix<double,nx*mpc_N,1>          Cqp;
@@ -72,6 +77,7 @@ private:
     double alpha;
     Eigen::Matrix<double,nu*ch, nu*ch>          H;
     Eigen::Matrix<double,nu * ch, 1>              c;
+    Eigen::Matrix<double,nu*ch,1>               delta_U;
 
     Eigen::Matrix<double,nu*ch,1>               u_low, u_up;
     Eigen::Matrix<double,nc*ch, nu*ch>          As;
@@ -6,6 +6,8 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
  <web@openloong.org.cn>
 */
 #include "priority_tasks.h"
+#include <algorithm>
+#include <iterator>
 
 void PriorityTasks::addTask(const char* name) {
     taskLib.emplace_back(name);
@@ -63,37 +65,130 @@ void PriorityTasks::printTaskInfo() {
     }
 }
 
+static bool rangesOverlap(const ColRanges &a, const ColRanges &b) {
+    size_t i=0, j=0;
+    while (i<a.size() && j<b.size()) {
+        if (a[i].start+a[i].size<=b[j].start)
+            i++;
+        else if (b[j].start+b[j].size<=a[i].start)
+            j++;
+        else
+            return true;
+    }
+    return false;
+}
+
+static ColRanges intersectRanges(const ColRanges &a, const ColRanges &b) {
+    ColRanges res;
+    size_t i=0, j=0;
+    while (i<a.size() && j<b.size()) {
+        int start=std::max(a[i].start, b[j].start);
+        int end=std::min(a[i].start+a[i].size, b[j].start+b[j].size);
+        if (start<end)
+            res.push_back({start, end-start});
+        if (a[i].start+a[i].size<b[j].start+b[j].size)
+            i++;
+        else
+            j++;
+    }
+    return res;
+}
+
+static void uniteRanges(ColRanges &a, const ColRanges &b) {
+    ColRanges all;
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(all),
+               [](const ColRange &x, const ColRange &y) { return x.start<y.start; });
+    a.clear();
+    for (const ColRange &r : all) {
+        if (!a.empty() && r.start<=a.back().start+a.back().size)
+            a.back().size=std::max(a.back().size, r.start+r.size-a.back().start);
+        else
+            a.push_back(r);
+    }
+}
+
+void Task::setActiveCols(bool exploitSparsity) {
+    activeCols.clear();
+    for (int j=0;j<J.cols();j++)
+        if (!exploitSparsity || !J.col(j).isZero(0)) {
+            if (!activeCols.empty() && activeCols.back().start+activeCols.back().size==j)
+                activeCols.back().size++;
+            else
+                activeCols.push_back({j, 1});
+        }
+}
+
+void Task::factorize(const Eigen::MatrixXd &dyn_M_inv) {
+    WinvJpreT.setZero(Jpre.cols(), Jpre.rows());
+    MinvJpreT.setZero(Jpre.cols(), Jpre.rows());
+    JWJ.setZero(Jpre.rows(), Jpre.rows());
+    for (const ColRange &r : activeCols) {
+        WinvJpreT.middleRows(r.start, r.size) = W.diagonal().segment(r.start, r.size).cwiseInverse().asDiagonal() *
+                                                Jpre.middleCols(r.start, r.size).transpose();
+        JWJ.noalias() += Jpre.middleCols(r.start, r.size) * WinvJpreT.middleRows(r.start, r.size);
+        MinvJpreT.noalias() += dyn_M_inv.middleCols(r.start, r.size) * Jpre.middleCols(r.start, r.size).transpose();
+    }
+    cod.compute(JWJ);
+    JMJ.setZero(Jpre.rows(), Jpre.rows());
+    for (const ColRange &r : activeCols)
+        JMJ.noalias() += Jpre.middleCols(r.start, r.size) * MinvJpreT.middleRows(r.start, r.size);
+    codDyn.compute(JMJ);
+}
+
+Eigen::VectorXd Task::pinvTimes(const Eigen::VectorXd &x) const {
+    return WinvJpreT * cod.solve(x);
+}
+
+Eigen::VectorXd Task::dynPinvTimes(const Eigen::VectorXd &x) const {
+    return MinvJpreT * codDyn.solve(x);
+}
+
+// X*Jpre^+ = X*W^-1*Jpre'*A^+ = (A^+ * (X*W^-1*Jpre')')' with A = Jpre*W^-1*Jpre' symmetric,
+// X*W^-1*Jpre' only sums over the columns X and Jpre have in common
+void Task::projectRows(Eigen::MatrixXd &X, ColRanges &cols) const {
+    if (!rangesOverlap(cols, activeCols))
+        return;
+    Eigen::MatrixXd XWJt = Eigen::MatrixXd::Zero(X.rows(), Jpre.rows());
+    for (const ColRange &r : intersectRanges(cols, activeCols))
+        XWJt.noalias() += X.middleCols(r.start, r.size) * WinvJpreT.middleRows(r.start, r.size);
+    Eigen::MatrixXd XPinv = cod.solve(XWJt.transpose()).transpose();
+    for (const ColRange &r : activeCols)
+        X.middleCols(r.start, r.size).noalias() -= XPinv * Jpre.middleCols(r.start, r.size);
+    uniteRanges(cols, activeCols);
+}
+
 void PriorityTasks::computeAll(const Eigen::VectorXd &des_delta_q,const Eigen::VectorXd &des_dq, const Eigen::VectorXd &des_ddq, const Eigen::MatrixXd &dyn_M, const Eigen::MatrixXd &dyn_M_inv, const Eigen::VectorXd &dq) {
     int curId=startId;
     int parentId=taskLib[curId].parentId;
     int childId=taskLib[curId].childId;
+    solvedIds.clear();
     for (int i=0;i<taskLib.size();i++)
     {
+        Task &cur=taskLib[curId];
+        // Jpre=J*N, N=N_parent*(I-Jpre_parent^+*Jpre_parent) applied row-wise through all tasks above
+        cur.setActiveCols(exploitSparsity);
+        cur.Jpre=cur.J;
+        for (int id : solvedIds)
+            taskLib[id].projectRows(cur.Jpre, cur.activeCols);
+        cur.factorize(dyn_M_inv);
+        Eigen::VectorXd ddxcmd= cur.ddxDes + cur.kp * cur.errX+cur.kd*cur.derrX;
         if (parentId==-1){
-            taskLib[curId].N=Eigen::MatrixXd::Identity(taskLib[curId].J.cols(),taskLib[curId].J.cols());
-            taskLib[curId].Jpre=taskLib[curId].J*taskLib[curId].N;
-            taskLib[curId].delta_q=des_delta_q+ pseudoInv_right_weighted(taskLib[curId].Jpre,taskLib[curId].W)*taskLib[curId].errX;
-            taskLib[curId].dq=des_dq;
-            Eigen::VectorXd ddxcmd= taskLib[curId].ddxDes + taskLib[curId].kp * taskLib[curId].errX+taskLib[curId].kd*taskLib[curId].derrX;
-            taskLib[curId].ddq= des_ddq + dyn_pseudoInv(taskLib[curId].Jpre,dyn_M_inv,true) * (ddxcmd - taskLib[curId].dJ * dq);
-//            std::cout<<taskLib[curId].taskName<<std::endl<<taskLib[curId].delta_q.transpose()<<std::endl;
+            cur.delta_q=des_delta_q+ cur.pinvTimes(cur.errX);
+            cur.dq=des_dq;
+            cur.ddq= des_ddq + cur.dynPinvTimes(ddxcmd - cur.dJ * dq);
+//            std::cout<<cur.taskName<<std::endl<<cur.delta_q.transpose()<<std::endl;
         }
         else{
-            taskLib[curId].N=taskLib[parentId].N*
-                    (Eigen::MatrixXd::Identity(taskLib[parentId].Jpre.cols(),taskLib[parentId].Jpre.cols())- pseudoInv_right_weighted(taskLib[parentId].Jpre,taskLib[parentId].W)*taskLib[parentId].Jpre);
-            taskLib[curId].Jpre=taskLib[curId].J*taskLib[curId].N;
-            taskLib[curId].delta_q=taskLib[parentId].delta_q+ pseudoInv_right_weighted(taskLib[curId].Jpre,taskLib[curId].W)*(taskLib[curId].errX-
-                    taskLib[curId].J*taskLib[parentId].delta_q);
-            taskLib[curId].dq=taskLib[parentId].dq+ pseudoInv_right_weighted(taskLib[curId].Jpre,taskLib[curId].W)*(taskLib[curId].dxDes-
-                    taskLib[curId].J*taskLib[parentId].dq);
-            Eigen::VectorXd ddxcmd= taskLib[curId].ddxDes + taskLib[curId].kp * taskLib[curId].errX+taskLib[curId].kd*taskLib[curId].derrX;
-            taskLib[curId].ddq= taskLib[parentId].ddq + dyn_pseudoInv(taskLib[curId].Jpre,dyn_M_inv,true) *
-                                                        (ddxcmd-taskLib[curId].dJ*dq-taskLib[curId].J*taskLib[parentId].ddq);
-//            std::cout<<taskLib[curId].taskName<<std::endl<<taskLib[curId].delta_q.transpose()<<std::endl;
+            const Task &parent=taskLib[parentId];
+            cur.delta_q=parent.delta_q+ cur.pinvTimes(cur.errX-cur.J*parent.delta_q);
+            cur.dq=parent.dq+ cur.pinvTimes(cur.dxDes-cur.J*parent.dq);
+            cur.ddq= parent.ddq + cur.dynPinvTimes(ddxcmd-cur.dJ*dq-cur.J*parent.ddq);
+//            std::cout<<cur.taskName<<std::endl<<cur.delta_q.transpose()<<std::endl;
         }
-//        printf("task: %s\n", taskLib[curId].taskName.c_str());
-//        Eigen::FullPivLU<Eigen::MatrixXd> lu_decomp(taskLib[curId].Jpre);
-//        printf("taskJacobian rank: %d, rows: %d\n", lu_decomp.rank(), taskLib[curId].Jpre.rows());
+        solvedIds.push_back(curId);
+//        printf("task: %s\n", cur.taskName.c_str());
+//        Eigen::FullPivLU<Eigen::MatrixXd> lu_decomp(cur.Jpre);
+//        printf("taskJacobian rank: %d, rows: %d\n", lu_decomp.rank(), cur.Jpre.rows());
         if (childId!=-1){
             parentId=curId;
             curId=childId;
@@ -106,16 +201,3 @@ void PriorityTasks::computeAll(const Eigen::VectorXd &des_delta_q,const Eigen::V
     out_dq=taskLib[curId].dq;
     out_ddq=taskLib[curId].ddq;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -13,18 +13,40 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
 #include <vector>
 #include <string>
 #include <iostream>
+
+// contiguous run of columns [start, start+size)
+struct ColRange{
+    int start, size;
+};
+using ColRanges = std::vector<ColRange>; // sorted, disjoint, not adjacent
+
 struct Task{
     std::string taskName;
     int id;
     int parentId, childId;
     Eigen::VectorXd dxDes,ddxDes;
     Eigen::VectorXd delta_q, dq, ddq;
-    Eigen::MatrixXd J, dJ, Jpre;
-    Eigen::MatrixXd N;
+    Eigen::MatrixXd J, dJ, Jpre; // Jpre = J*N, N: null-space projector of the higher priority tasks, never formed
+    ColRanges activeCols; // columns of Jpre that may be nonzero, Jpre is zero elsewhere
     Eigen::MatrixXd kp, kd;
     Eigen::DiagonalMatrix<double,-1> W; // weighted matrix for pseudo inverse
     Eigen::VectorXd errX, derrX;
     Task(std::string name){taskName=name;};
+
+    // Jpre is factorized once per tick and the pseudo inverses are only applied to vectors:
+    // weighted Jpre^+ = W^-1*Jpre'*(Jpre*W^-1*Jpre')^+, dynamic Jpre^+ = M^-1*Jpre'*(Jpre*M^-1*Jpre')^+
+    // W is diagonal, so a row block X with no active column in common with this task is left unchanged by the
+    // projection and the weighted pseudo inverse only touches the active columns. All products run over the
+    // active column ranges (limbs are contiguous in q), limb-local tasks cost with their column count, not nv.
+    void setActiveCols(bool exploitSparsity);                     // nonzero column ranges of J, or all columns
+    void factorize(const Eigen::MatrixXd &dyn_M_inv);
+    Eigen::VectorXd pinvTimes(const Eigen::VectorXd &x) const;    // weighted Jpre^+ * x
+    Eigen::VectorXd dynPinvTimes(const Eigen::VectorXd &x) const; // dynamic Jpre^+ * x
+    // X = X*(I - Jpre^+ * Jpre), weighted Jpre^+, cols: nonzero columns of X, grows by activeCols
+    void projectRows(Eigen::MatrixXd &X, ColRanges &cols) const;
+private:
+    Eigen::MatrixXd WinvJpreT, MinvJpreT, JWJ, JMJ;
+    Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> cod, codDyn;
 };
 class PriorityTasks {
 public:
@@ -33,6 +55,8 @@ public:
     std::vector<int> idList, parentIdList, childIdList;
     Eigen::VectorXd out_delta_q, out_dq, out_ddq;
     int startId;
+    std::vector<int> solvedIds; // tasks already solved in the current computeAll, in priority order
+    bool exploitSparsity{true}; // false: every task spans all nv columns (dense null-space cascade)
     void addTask(const char* name);
     int getId(const std::string& name);
     int getId(const char* name);
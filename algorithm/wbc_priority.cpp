@@ -20,6 +20,10 @@ WBC_priority::WBC_priority(int model_nv_In, int QP_nvIn, int QP_ncIn, double miu
     miu = miu_In;
     QP_nc = QP_ncIn;
     QP_nv = QP_nvIn;
+    if (QP_nv != QP_nv_des || QP_nc != QP_nc_des) {
+        std::cout << "WBC QP must be " << QP_nv_des << " x " << QP_nc_des << ", got " << QP_nv << " x " << QP_nc << std::endl;
+        throw std::runtime_error("Failed to create WBC_priority.");
+    }
     Sf = Eigen::MatrixXd::Zero(6, model_nv);
     Sf.block<6, 6>(0, 0) = Eigen::MatrixXd::Identity(6, 6);
     St_qpV2 = Eigen::MatrixXd::Zero(model_nv, model_nv - 6); // 6 means the dims of floating base
@@ -48,6 +52,10 @@ WBC_priority::WBC_priority(int model_nv_In, int QP_nvIn, int QP_ncIn, double miu
     eigen_ddq_Opt = Eigen::VectorXd::Zero(model_nv);
     eigen_fr_Opt = Eigen::VectorXd::Zero(12);
     eigen_tau_Opt = Eigen::VectorXd::Zero(model_nv - 6);
+    tauRes = Eigen::VectorXd::Zero(model_nv);
+    tauJointRes = Eigen::VectorXd::Zero(model_nv - 6);
+    Q2 = Eigen::MatrixXd::Identity(6, 6);   // QP weights of delta_b and delta_Fr
+    Q1 = Eigen::MatrixXd::Identity(12, 12);
 
     delta_q_final_kin = Eigen::VectorXd::Zero(model_nv);
     dq_final_kin = Eigen::VectorXd::Zero(model_nv);;
@@ -201,14 +209,28 @@ void WBC_priority::dataBusWrite(DataBus &robotState) {
 
 // QP problem contains joint torque, QP_nv=6+12, QP_nc=22;
 void WBC_priority::computeTau() {
-    // constust the QP problem, refer to the md file for more details
-    Eigen::MatrixXd eigen_qp_A1 = Eigen::MatrixXd::Zero(6, QP_nv);// 18 means the sum of dims of delta_r and delta_Fr
-    eigen_qp_A1.block<6, 6>(0, 0) = Sf * dyn_M * St_qpV1;
+    buildTauQP();
+    solveTauQP();
+}
 
-    eigen_qp_A1.block<6, 12>(0, 6) = -Sf * Jfe.transpose();
+// assembles the QP directly in the qpOASES buffers, all intermediates are fixed-size so nothing is allocated
+void WBC_priority::buildTauQP() {
+    // the qpOASES buffers are row-major
+    Eigen::Map<Eigen::Matrix<double, QP_nv_des, QP_nv_des, Eigen::RowMajor>> eigen_qp_H(qp_H);
+    Eigen::Map<Eigen::Matrix<double, QP_nc_des, QP_nv_des, Eigen::RowMajor>> eigen_qp_A_final(qp_A);
+    Eigen::Map<Eigen::Matrix<double, QP_nv_des, 1>> eigen_qp_g(qp_g);
+    Eigen::Map<Eigen::Matrix<double, QP_nc_des, 1>> eigen_qp_lbA(qp_lbA);
+    Eigen::Map<Eigen::Matrix<double, QP_nc_des, 1>> eigen_qp_ubA(qp_ubA);
 
-    Eigen::VectorXd eqRes = Eigen::VectorXd::Zero(6);
-    eqRes = -Sf * dyn_M * ddq_final_kin - Sf * dyn_Non + Sf * Jfe.transpose() * Fr_ff;
+    // constust the QP problem, refer to the md file for more details
+    // floating-base rows: Sf * dyn_M * St_qpV1 is the top-left 6x6 block of dyn_M, Sf * Jfe' the first 6 columns of Jfe
+    eigen_qp_A_final.block<6, 6>(0, 0) = dyn_M.block<6, 6>(0, 0);
+    eigen_qp_A_final.block<6, 12>(0, 6) = -Jfe.leftCols<6>().transpose();
+
+    Eigen::Matrix<double, 6, 1> eqRes;
+    eqRes.noalias() = -dyn_M.topRows<6>() * ddq_final_kin;
+    eqRes -= dyn_Non.head<6>();
+    eqRes.noalias() += Jfe.leftCols<6>().transpose() * Fr_ff;
 
     Eigen::Matrix3d Rfe;
     if (motionStateCur==DataBus::Stand){
@@ -224,7 +246,8 @@ void WBC_priority::computeTau() {
     Mw2b.block(6,6,3,3)=Rfe.transpose();
     Mw2b.block(9,9,3,3)=Rfe.transpose();
 
-    Eigen::MatrixXd W = Eigen::MatrixXd::Zero(16, 12);
+    Eigen::Matrix<double, 16, 12> W;
+    W.setZero();
     W(0, 0) = 1;
     W(0, 2) = sqrt(2) / 2.0 * miu;
     W(1, 0) = -1;
@@ -233,12 +256,11 @@ void WBC_priority::computeTau() {
     W(2, 2) = sqrt(2) / 2.0 * miu;
     W(3, 1) = -1;
     W(3, 2) = sqrt(2) / 2.0 * miu;
-    W.block<4, 4>(4, 2) = Eigen::MatrixXd::Identity(4, 4);
+    W.block<4, 4>(4, 2).setIdentity();
     W.block<8, 6>(8, 6) = W.block<8, 6>(0, 0);
     W=W*Mw2b;
 
-    Eigen::VectorXd f_low = Eigen::VectorXd::Zero(16);
-    Eigen::VectorXd f_upp = Eigen::VectorXd::Zero(16);
+    Eigen::Matrix<double, 16, 1> f_low, f_upp;
     Eigen::Vector3d tau_upp_fe, tau_low_fe;
     if (motionStateCur==DataBus::Stand) {
         tau_upp_fe = tau_upp_stand_L;
@@ -292,31 +314,25 @@ void WBC_priority::computeTau() {
         }
     }
 
-    Eigen::MatrixXd eigen_qp_A2 = Eigen::MatrixXd::Zero(16, 18);
-    eigen_qp_A2.block<16, 12>(0, 6) = W;
-    Eigen::VectorXd neqRes_low = Eigen::VectorXd::Zero(16);
-    Eigen::VectorXd neqRes_upp = Eigen::VectorXd::Zero(16);
-
-    neqRes_low = f_low - W * Fr_ff;
-    neqRes_upp = f_upp - W * Fr_ff;
+    // contact wrench rows
+    eigen_qp_A_final.block<16, 6>(6, 0).setZero();
+    eigen_qp_A_final.block<16, 12>(6, 6) = W;
 
-    Eigen::MatrixXd eigen_qp_A_final = Eigen::MatrixXd::Zero(QP_nc, QP_nv);
-    eigen_qp_A_final.block<6, 18>(0, 0) = eigen_qp_A1;
-    eigen_qp_A_final.block<16, 18>(6, 0) = eigen_qp_A2;
+    Eigen::Matrix<double, 16, 1> WFr_ff;
+    WFr_ff.noalias() = W * Fr_ff;
 
-    Eigen::VectorXd eigen_qp_lbA = Eigen::VectorXd::Zero(22);
-    Eigen::VectorXd eigen_qp_ubA = Eigen::VectorXd::Zero(22);
+    eigen_qp_lbA.head<6>() = eqRes;
+    eigen_qp_lbA.tail<16>() = f_low - WFr_ff;
+    eigen_qp_ubA.head<6>() = eqRes;
+    eigen_qp_ubA.tail<16>() = f_upp - WFr_ff;
+    // qpOASES treats bounds beyond INFTY as unbounded
+    eigen_qp_lbA = eigen_qp_lbA.cwiseMax(-qpOASES::INFTY);
+    eigen_qp_ubA = eigen_qp_ubA.cwiseMin(qpOASES::INFTY);
 
-    eigen_qp_lbA.block<6, 1>(0, 0) = eqRes;
-    eigen_qp_lbA.block<16, 1>(6, 0) = neqRes_low;
-    eigen_qp_ubA.block<6, 1>(0, 0) = eqRes;
-    eigen_qp_ubA.block<16, 1>(6, 0) = neqRes_upp;
-
-    Eigen::MatrixXd eigen_qp_H = Eigen::MatrixXd::Zero(QP_nv, QP_nv);
-    Q2 = Eigen::MatrixXd::Identity(6, 6);
-    Q1 = Eigen::MatrixXd::Identity(12, 12);
+    eigen_qp_H.setZero();
     eigen_qp_H.block<6, 6>(0, 0) = Q2 * 2.0 * 1e7;
     eigen_qp_H.block<12, 12>(6, 6) = Q1 * 2.0 * 1e1;
+    eigen_qp_g.setZero();
 
     // obj: (1/2)x'Hx+x'g
     // s.t. lbA<=Ax<=ubA
@@ -328,21 +344,45 @@ void WBC_priority::computeTau() {
 //    qpOASES::real_t qp_ubA[QP_nc];
 //    qpOASES::real_t xOpt_iniGuess[QP_nv];
 
-    copy_Eigen_to_real_t(qp_H, eigen_qp_H, eigen_qp_H.rows(), eigen_qp_H.cols());
-    copy_Eigen_to_real_t(qp_A, eigen_qp_A_final, eigen_qp_A_final.rows(), eigen_qp_A_final.cols());
-    copy_Eigen_to_real_t(qp_lbA, eigen_qp_lbA, eigen_qp_lbA.rows(), eigen_qp_lbA.cols());
-    copy_Eigen_to_real_t(qp_ubA, eigen_qp_ubA, eigen_qp_ubA.rows(), eigen_qp_ubA.cols());
-
-    qpOASES::returnValue res;
     for (int i = 0; i < QP_nv; i++) {
         xOpt_iniGuess[i] = 0;
 //        xOpt_iniGuess[i] =eigen_xOpt(i);
-        qp_g[i] = 0;
     }
+}
+
+// solves the assembled QP and recovers the joint torques, nothing is allocated outside qpOASES
+void WBC_priority::solveTauQP() {
+    qpOASES::returnValue res;
     nWSR = 200;
     cpu_time = timeStep;
+    // warm start unless the swing-leg bounds changed, a failed hotstart falls back to a cold init in the same tick
+    const bool contactChanged = legStateCur != qpLegState || motionStateCur != qpMotionState;
+    qpOASES::int_t hotNWSR = 0;
+    qpOASES::real_t hotCpuTime = 0;
+    lastHotstart = false;
+    if (useWarmStart && qpInitialized && !contactChanged) {
+        res = QP_prob.hotstart(qp_H, qp_g, qp_A, NULL, NULL, qp_lbA, qp_ubA, nWSR, &cpu_time);
+        if (res == qpOASES::SUCCESSFUL_RETURN) {
+            lastHotstart = true;
+            hotstartCount++;
+        } else {
+            hotstartFailCount++;
+            hotNWSR = nWSR;
+            hotCpuTime = cpu_time;
+        }
+    }
+    if (!lastHotstart) {
+        nWSR = 200;
+        cpu_time = timeStep;
 //    QP_prob.reset();
-    res = QP_prob.init(qp_H, qp_g, qp_A, NULL, NULL, qp_lbA, qp_ubA, nWSR, &cpu_time, xOpt_iniGuess);
+        res = QP_prob.init(qp_H, qp_g, qp_A, NULL, NULL, qp_lbA, qp_ubA, nWSR, &cpu_time, xOpt_iniGuess);
+        nWSR += hotNWSR;
+        cpu_time += hotCpuTime;
+        coldInitCount++;
+    }
+    qpInitialized = res == qpOASES::SUCCESSFUL_RETURN;
+    qpLegState = legStateCur;
+    qpMotionState = motionStateCur;
     qpStatus = qpOASES::getSimpleStatus(res);
 //    if (res==qpOASES::SUCCESSFUL_RETURN)
 //        printf("WBC-QP: successful_return\n");
@@ -351,7 +391,7 @@ void WBC_priority::computeTau() {
 //    else if (res==qpOASES::RET_INIT_FAILED)
 //        printf("WBC-QP: init_failed\n");
 
-    qpOASES::real_t xOpt[QP_nv];
+    qpOASES::real_t xOpt[QP_nv_des];
     QP_prob.getPrimalSolution(xOpt);
     if (res == qpOASES::SUCCESSFUL_RETURN)
         for (int i = 0; i < QP_nv; i++)
@@ -361,18 +401,11 @@ void WBC_priority::computeTau() {
     eigen_ddq_Opt.block<6, 1>(0, 0) += eigen_xOpt.block<6, 1>(0, 0);
     eigen_fr_Opt = Fr_ff + eigen_xOpt.block<12, 1>(6, 0);
 
-    if (qpStatus != 0){
-        Eigen::MatrixXd A_x;
-        Eigen::VectorXd xOpt_iniGuess_m(QP_nv,1);
-        for (int i=0; i < QP_nv;i++)
-            xOpt_iniGuess_m(i) = xOpt_iniGuess[i];
-
-    }
-
-    Eigen::VectorXd tauRes;
-    tauRes = dyn_M * eigen_ddq_Opt + dyn_Non - Jfe.transpose() * eigen_fr_Opt;
+    tauRes.noalias() = dyn_M * eigen_ddq_Opt;
+    tauRes += dyn_Non;
+    tauRes.noalias() -= Jfe.transpose() * eigen_fr_Opt;
 
-    tauJointRes = tauRes.block(6, 0, model_nv - 6, 1);
+    tauJointRes = tauRes.tail(model_nv - 6);
 //    std::cout<<"qpRes_frOpt"<<std::endl;
 //    std::cout<<eigen_fr_Opt.transpose()<<std::endl;
 
@@ -787,16 +820,6 @@ void WBC_priority::computeDdq(Pin_KinDyn &pinKinDynIn) {
 
 }
 
-void WBC_priority::copy_Eigen_to_real_t(qpOASES::real_t *target, const Eigen::MatrixXd &source, int nRows, int nCols) {
-    int count = 0;
-
-    for (int i = 0; i < nRows; i++) {
-        for (int j = 0; j < nCols; j++) {
-            target[count++] = isinf(source(i, j)) ? qpOASES::INFTY : source(i, j);
-        }
-    }
-}
-
 void WBC_priority::setQini(const Eigen::VectorXd &qIniDesIn, const Eigen::VectorXd &qIniCurIn) {
     qIniDes = qIniDesIn;
     qIniCur = qIniCurIn;
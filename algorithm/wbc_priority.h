@@ -60,22 +60,38 @@ public:
 
     PriorityTasks kin_tasks_walk, kin_tasks_stand;
     void setQini(const Eigen::VectorXd &qIniDes, const Eigen::VectorXd &qIniCur);
-    void computeTau();
+    void computeTau();  // buildTauQP() then solveTauQP()
+    void buildTauQP();  // QP assembly straight into the qpOASES buffers, allocation free
+    void solveTauQP();  // QP solve and joint torque recovery
     void dataBusRead(const DataBus &robotState);
     void dataBusWrite(DataBus &robotState);
     void computeDdq(Pin_KinDyn &pinKinDynIn);
+
+    // warm start of the torque QP: H and A change every tick, so the previous active set and solution are reused
+    // through SQProblem::hotstart. A cold init is done on the first tick, after a leg or motion state change
+    // (the swing-leg force bounds change) and when the hotstart fails.
+    bool useWarmStart{false};
+    qpOASES::int_t lastNWSR() const { return last_nWSR; }         // working set recalculations of the last tick
+    qpOASES::real_t lastCpuTime() const { return last_cpu_time; } // QP solve time of the last tick, s
+    bool lastWarmStarted() const { return lastHotstart; }          // last tick solved by hotstart without fallback
+    long hotstartNum() const { return hotstartCount; }
+    long coldInitNum() const { return coldInitCount; }
+    long hotstartFailNum() const { return hotstartFailCount; }
 private:
     double timeStep{0.001};
-    qpOASES::QProblem QP_prob;
+    qpOASES::SQProblem QP_prob;
     Eigen::MatrixXd Sf; // floating-base dynamics selection matrix
     Eigen::MatrixXd St_qpV1, St_qpV2; // state selection matrix
 
     qpOASES::int_t nWSR=100, last_nWSR{0};
     qpOASES::real_t cpu_time=0.1, last_cpu_time{0};
     int qpStatus{0};
+    bool qpInitialized{false}, lastHotstart{false};
+    DataBus::LegState qpLegState{DataBus::DSt};
+    DataBus::MotionState qpMotionState{DataBus::Stand};
+    long hotstartCount{0}, coldInitCount{0}, hotstartFailCount{0};
     int QP_nv;
     int QP_nc;
-    void copy_Eigen_to_real_t(qpOASES::real_t* target, const Eigen::MatrixXd &source, int nRows, int nCols);
     Eigen::MatrixXd J_base, dJ_base, Jcom;
     Eigen::MatrixXd J_hip_link;
     Eigen::Vector3d base_pos_des, base_pos, base_rpy_des, base_rpy_cur, hip_link_pos;
@@ -85,6 +101,7 @@ private:
     Eigen::Matrix3d stance_fe_rot_cur_W;
     Eigen::Vector3d stanceDesPos_W;
     Eigen::VectorXd des_ddq, des_dq, des_delta_q, des_q;
+    Eigen::VectorXd tauRes; // model_nv, preallocated for solveTauQP
     Eigen::VectorXd qIniDes, qIniCur;
 
     static const int QP_nv_des=18;
@@ -41,6 +41,15 @@ struct DataBus{
     double fLtouch;
     double fRtouch;
 
+    // contact estimation results (ContactEstimator), written in the control loop
+    bool contactEstValid{false};  // true once the estimator has written the bus
+    bool fLcontactEst{false};     // left foot in contact
+    bool fRcontactEst{false};
+    double fLcontactProb{0};      // GT2FCM contact probability
+    double fRcontactProb{0};
+    double fLstableContactProb{0}; // IT2FIS stable (non-slipping) contact probability
+    double fRstableContactProb{0};
+
 
     std::vector<double> motors_pos_cur;
     std::vector<double> motors_vel_cur;
@@ -0,0 +1,101 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Live stream of a few DataBus signals from a control loop, through TelemetryPublisher.
+// The loop copies the signals into a DataBusSample and push()es it, the publisher thread formats one flat JSON object
+// per sample and sends it as a UDP datagram, e.g. to the UDP server (JSON protocol) of PlotJuggler.
+// Samples may be dropped when the receiver or the network is slow, record/datalog.log stays the complete record.
+//
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "data_bus.h"
+
+struct DataBusSample {
+    double simTime;
+    double basePos[3];
+    double baseRpy[3];
+    double baseLinVel[3];       // dq(0..2), world frame
+    double feLPos[3];           // foot ends, world frame
+    double feRPos[3];
+    double fLcontactProb, fRcontactProb;
+    int32_t legState;           // DataBus::LegState
+    int32_t motionState;        // DataBus::MotionState
+};
+
+// loop side, no allocation
+inline void fillDataBusSample(const DataBus &robotState, double simTime, DataBusSample &sample) {
+    sample.simTime = simTime;
+    for (int i = 0; i < 3; i++) {
+        sample.basePos[i] = robotState.q(i);
+        sample.baseRpy[i] = robotState.base_rpy(i);
+        sample.baseLinVel[i] = robotState.dq(i);
+        sample.feLPos[i] = robotState.fe_l_pos_W(i);
+        sample.feRPos[i] = robotState.fe_r_pos_W(i);
+    }
+    sample.fLcontactProb = robotState.fLcontactProb;
+    sample.fRcontactProb = robotState.fRcontactProb;
+    sample.legState = robotState.legState;
+    sample.motionState = robotState.motionState;
+}
+
+// one flat JSON object, returns the length, 0 if buf is too small
+inline size_t formatDataBusSample(const DataBusSample &s, char *buf, size_t size) {
+    int n = snprintf(buf, size,
+                     "{\"t\":%.6f,\"base_pos\":[%.6g,%.6g,%.6g],\"base_rpy\":[%.6g,%.6g,%.6g],"
+                     "\"base_vel\":[%.6g,%.6g,%.6g],\"fe_l_pos\":[%.6g,%.6g,%.6g],\"fe_r_pos\":[%.6g,%.6g,%.6g],"
+                     "\"contact_prob\":[%.6g,%.6g],\"leg_state\":%d,\"motion_state\":%d}",
+                     s.simTime, s.basePos[0], s.basePos[1], s.basePos[2], s.baseRpy[0], s.baseRpy[1], s.baseRpy[2],
+                     s.baseLinVel[0], s.baseLinVel[1], s.baseLinVel[2], s.feLPos[0], s.feLPos[1], s.feLPos[2],
+                     s.feRPos[0], s.feRPos[1], s.feRPos[2], s.fLcontactProb, s.fRcontactProb, (int) s.legState,
+                     (int) s.motionState);
+    return n > 0 && static_cast<size_t>(n) < size ? static_cast<size_t>(n) : 0;
+}
+
+// TelemetryPublisher sink: one datagram per sample, runs on the publisher thread
+class DataBusUdpSink {
+public:
+    // throws std::runtime_error if the socket cannot be created or the address is invalid
+    DataBusUdpSink(const std::string &host, uint16_t port) {
+        memset(&dest, 0, sizeof(dest));
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(port);
+        if (inet_pton(AF_INET, host.c_str(), &dest.sin_addr) != 1)
+            throw std::runtime_error("invalid telemetry address " + host);
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0)
+            throw std::runtime_error("telemetry socket failed");
+    }
+    DataBusUdpSink(const DataBusUdpSink &) = delete;
+    DataBusUdpSink &operator=(const DataBusUdpSink &) = delete;
+    ~DataBusUdpSink() { close(fd); }
+
+    void operator()(const DataBusSample *samples, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            size_t len = formatDataBusSample(samples[i], buf, sizeof(buf));
+            if (len == 0 || sendto(fd, buf, len, 0, reinterpret_cast<const sockaddr *>(&dest), sizeof(dest)) < 0)
+                sendErrors++;
+        }
+    }
+
+    uint64_t sendErrorNum() const { return sendErrors; }    // read after TelemetryPublisher::stop()
+
+private:
+    int fd{-1};
+    sockaddr_in dest;
+    char buf[1024];
+    uint64_t sendErrors{0};
+};
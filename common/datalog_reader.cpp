@@ -0,0 +1,139 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+#include "datalog_reader.h"
+#include <fstream>
+#include <stdexcept>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+DataLogReader::DataLogReader(const std::string &logPath, const std::string &scriptPath) {
+    std::string script = scriptPath;
+    if (script.empty()) {
+        size_t lastSlashPos = logPath.find_last_of('/');
+        script = (lastSlashPos == std::string::npos ? std::string() : logPath.substr(0, lastSlashPos + 1))
+                 + "matlabReadDataScript.txt";
+    }
+    readScript(script);
+
+    int fd = open(logPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open data log " + logPath);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat data log " + logPath);
+    }
+    mapSize = st.st_size;
+    if (mapSize > 0) {
+        void *addr = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map data log " + logPath);
+        }
+        madvise(addr, mapSize, MADV_SEQUENTIAL);
+        mapData = static_cast<const char *>(addr);
+    }
+    close(fd);
+}
+
+DataLogReader::~DataLogReader() {
+    if (mapData != nullptr)
+        munmap(const_cast<char *>(mapData), mapSize);
+}
+
+// lines look like  name=dataRec(:,start:end);  with 1-based inclusive columns
+void DataLogReader::readScript(const std::string &scriptPath) {
+    std::ifstream in(scriptPath);
+    if (!in)
+        throw std::runtime_error("Cannot open " + scriptPath);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t eq = line.find("=dataRec(:,");
+        if (eq == std::string::npos)
+            continue;
+        int start = 0, end = 0;
+        if (sscanf(line.c_str() + eq, "=dataRec(:,%d:%d)", &start, &end) != 2 || start < 1 || end < start)
+            throw std::runtime_error("Bad column range in " + scriptPath + ": " + line);
+        itemName.push_back(line.substr(0, eq));
+        itemStartCol.push_back(start - 1);
+        itemLen.push_back(end - start + 1);
+        colCount = std::max(colCount, end);
+    }
+    if (itemName.empty())
+        throw std::runtime_error("No recorded items in " + scriptPath);
+}
+
+int DataLogReader::findItem(const std::string &name) const {
+    auto it = std::find(itemName.begin(), itemName.end(), name);
+    return it == itemName.end() ? -1 : static_cast<int>(std::distance(itemName.begin(), it));
+}
+
+bool DataLogReader::hasItem(const std::string &name) const {
+    return findItem(name) >= 0;
+}
+
+int DataLogReader::itemColumn(const std::string &name) const {
+    int idx = findItem(name);
+    if (idx < 0)
+        throw std::runtime_error(name + " is not recorded in the data log");
+    return itemStartCol[idx];
+}
+
+int DataLogReader::itemLength(const std::string &name) const {
+    int idx = findItem(name);
+    if (idx < 0)
+        throw std::runtime_error(name + " is not recorded in the data log");
+    return itemLen[idx];
+}
+
+bool DataLogReader::nextRow(double *row) {
+    while (pos < mapSize) {
+        const char *begin = mapData + pos;
+        const char *lineEnd = static_cast<const char *>(memchr(begin, '\n', mapSize - pos));
+        if (lineEnd == nullptr)
+            lineEnd = mapData + mapSize;
+        pos = (lineEnd - mapData) + 1;
+
+        const char *p = begin;
+        int col = 0;
+        bool ok = true;
+        while (p < lineEnd && col < colCount) {
+            if (*p == '+')
+                p++;   // from_chars does not take a leading '+'
+            auto res = std::from_chars(p, lineEnd, row[col]);
+            if (res.ec != std::errc()) {
+                ok = false;
+                break;
+            }
+            col++;
+            p = res.ptr;
+            if (p < lineEnd && *p == ',')
+                p++;
+        }
+        while (p < lineEnd && (*p == '\r' || *p == ' '))
+            p++;
+        if (ok && col == colCount && p == lineEnd) {
+            rowCount++;
+            return true;
+        }
+        if (lineEnd != begin)
+            skipCount++;
+    }
+    return false;
+}
+
+void DataLogReader::rewind() {
+    pos = 0;
+    rowCount = 0;
+    skipCount = 0;
+}
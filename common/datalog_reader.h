@@ -0,0 +1,54 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Reader for the logs written by DataLogger. The column layout is taken from the matlabReadDataScript.txt written
+// next to the log, the log itself is mapped read-only and parsed line by line without copying it.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class DataLogReader {
+public:
+    // scriptPath defaults to matlabReadDataScript.txt in the folder of the log
+    explicit DataLogReader(const std::string &logPath, const std::string &scriptPath = "");
+    ~DataLogReader();
+    DataLogReader(const DataLogReader &) = delete;
+    DataLogReader &operator=(const DataLogReader &) = delete;
+
+    bool hasItem(const std::string &name) const;
+    int itemColumn(const std::string &name) const;   // first column of the item, throws if missing
+    int itemLength(const std::string &name) const;
+    int columns() const { return colCount; }
+
+    // parse the next complete line into row (columns() values), false at the end of the log.
+    // Lines with a wrong number of values (e.g. the last one of an interrupted run) are skipped.
+    bool nextRow(double *row);
+    void rewind();
+
+    size_t rowsRead() const { return rowCount; }
+    size_t rowsSkipped() const { return skipCount; }
+    size_t bytes() const { return mapSize; }
+
+private:
+    std::vector<std::string> itemName;
+    std::vector<int> itemStartCol;
+    std::vector<int> itemLen;
+    int colCount{0};
+
+    const char *mapData{nullptr};
+    size_t mapSize{0};
+    size_t pos{0};
+    size_t rowCount{0};
+    size_t skipCount{0};
+
+    void readScript(const std::string &scriptPath);
+    int findItem(const std::string &name) const;
+};
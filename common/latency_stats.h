@@ -0,0 +1,112 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Collects latency samples (in microseconds) of a loop and prints mean/percentiles on demand.
+// Storage is reserved up front so add() does not allocate inside a 1 kHz loop.
+//
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t capacity = 60000) {
+        samples.reserve(capacity);
+    }
+
+    void add(double us) {
+        if (samples.size() < samples.capacity())
+            samples.push_back(us);
+        else
+            overflow++;
+    }
+
+    void clear() {
+        samples.clear();
+        overflow = 0;
+    }
+
+    size_t count() const { return samples.size(); }    // stored samples only
+
+    // append the samples of another collector, grows the storage if needed (not for the loop itself)
+    void merge(const LatencyStats &other) {
+        if (samples.size() + other.samples.size() > samples.capacity())
+            samples.reserve(samples.size() + other.samples.size());
+        samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+        overflow += other.overflow;
+    }
+
+    // p in [0, 100]
+    double percentile(double p) const {
+        if (samples.empty())
+            return 0;
+        std::vector<double> sorted(samples);
+        size_t idx = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+        return sorted[idx];
+    }
+
+    double mean() const {
+        if (samples.empty())
+            return 0;
+        double sum = 0;
+        for (double v : samples)
+            sum += v;
+        return sum / samples.size();
+    }
+
+    double max() const {
+        return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+    }
+
+    void print(const char *name) const {
+        printf("%s: n=%zu mean=%.2f p50=%.2f p90=%.2f p99=%.2f max=%.2f us", name, samples.size(), mean(),
+               percentile(50), percentile(90), percentile(99), max());
+        if (overflow > 0)
+            printf(" (%zu samples not stored)", overflow);
+        printf("\n");
+    }
+
+    // binNum bins of binWidth us starting at 0, the last bin also collects everything above
+    void printHistogram(const char *name, double binWidth, int binNum) const {
+        std::vector<size_t> bins(binNum, 0);
+        for (double v : samples) {
+            int idx = v <= 0 ? 0 : static_cast<int>(v / binWidth);
+            bins[std::min(idx, binNum - 1)]++;
+        }
+        size_t peak = std::max<size_t>(1, *std::max_element(bins.begin(), bins.end()));
+        printf("%s: n=%zu", name, samples.size());
+        if (overflow > 0)
+            printf(" (%zu later samples not stored, not in the histogram)", overflow);
+        printf("\n");
+        for (int i = 0; i < binNum; i++) {
+            if (i < binNum - 1)
+                printf("  [%7.0f, %7.0f) us %8zu ", i * binWidth, (i + 1) * binWidth, bins[i]);
+            else
+                printf("  [%7.0f,     inf) us %8zu ", i * binWidth, bins[i]);
+            int bar = static_cast<int>(50.0 * bins[i] / peak + 0.5);
+            for (int k = 0; k < bar; k++)
+                printf("#");
+            printf("\n");
+        }
+    }
+
+    // steady clock in ns, comparable between processes on the same machine
+    static uint64_t nowNs() {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    std::vector<double> samples;
+    size_t overflow{0};
+};
@@ -0,0 +1,33 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Robot data shared by the control loop (walk_mpc_wbc) with external processes such as Contact_detection.
+// One frame per control tick goes through a ShmSeqlockRing, see shm_seqlock_ring.h.
+//
+#pragma once
+
+#include <cstdint>
+#include "shm_seqlock_ring.h"
+
+struct SharedRobotData {
+    double simTime;
+    double lF_pos[3];
+    double lF_acc[3];
+    double lF_rpy[3];
+    double lF_angular_vel[3];
+    double lF_linear_vel[3];
+    double hip_joint_pos;
+    double knee_joint_pos;
+    double Contactforce;
+    uint64_t writeStampNs;  // steady clock at publish, for latency statistics
+};
+
+// 64 frames: 64 ms of history at 1 kHz
+typedef ShmSeqlockRing<SharedRobotData, 64> RobotDataRing;
+
+static const char *const robotDataShmName = "/openloong_robot_data";
@@ -0,0 +1,251 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Single-producer/multi-consumer ring of N frames in POSIX shared memory, every slot protected by a seqlock.
+// Frames get sequence numbers 1, 2, 3, ... The producer never waits for readers, a reader that falls more
+// than N frames behind sees ReadLapped and can count the frames it missed. Readers either poll or block on
+// a futex until the producer publishes a newer frame.
+//
+// Slot version of frame s is 2s-1 while it is being written and 2s once complete, so a reader can tell
+// "not written yet", "complete" and "overwritten or torn" apart from the two version reads around the copy.
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <climits>
+#include <ctime>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+template<typename T, uint32_t N>
+class ShmSeqlockRing {
+    static_assert(std::is_trivially_copyable<T>::value, "ring frames are copied with memcpy");
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "shared memory atomics must be lock free");
+
+public:
+    enum ReadStatus {
+        ReadOk,         // frame copied
+        ReadNoData,     // frame not published yet
+        ReadLapped      // frame overwritten by the producer, also reported for a copy that raced with the writer
+    };
+
+    // per reader position in the ring
+    struct Cursor {
+        uint64_t next{1};       // next sequence number to read
+        uint64_t dropped{0};    // frames overwritten before this reader got to them
+    };
+
+    ShmSeqlockRing() = default;
+    ShmSeqlockRing(const ShmSeqlockRing &) = delete;
+    ShmSeqlockRing &operator=(const ShmSeqlockRing &) = delete;
+    ~ShmSeqlockRing() { detach(); }
+
+    // producer side: create (or take over) the segment and reset it, returns false on failure
+    bool create(const std::string &name) {
+        detach();
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0666);
+        if (fd < 0) {
+            perror("shm_open failed");
+            return false;
+        }
+        if (ftruncate(fd, sizeof(Layout)) != 0) {
+            perror("ftruncate failed");
+            close(fd);
+            return false;
+        }
+        if (!map(fd))
+            return false;
+        memset(static_cast<void *>(shm), 0, sizeof(Layout));
+        shm->header.capacity = N;
+        shm->header.frameSize = sizeof(T);
+        shm->header.magic.store(magicValue, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side: attach to a segment created by the producer, returns false on failure or layout mismatch
+    bool open(const std::string &name) {
+        detach();
+        int fd = shm_open(name.c_str(), O_RDWR, 0666);
+        if (fd < 0) {
+            perror("shm_open failed");
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size != static_cast<off_t>(sizeof(Layout))) {
+            fprintf(stderr, "shared memory %s has size %ld, expected %zu\n", name.c_str(), (long) st.st_size,
+                    sizeof(Layout));
+            close(fd);
+            return false;
+        }
+        if (!map(fd))
+            return false;
+        if (shm->header.magic.load(std::memory_order_acquire) != magicValue ||
+            shm->header.capacity != N || shm->header.frameSize != sizeof(T)) {
+            fprintf(stderr, "shared memory %s does not hold a matching ring\n", name.c_str());
+            detach();
+            return false;
+        }
+        return true;
+    }
+
+    void detach() {
+        if (shm) {
+            munmap(shm, sizeof(Layout));
+            shm = nullptr;
+        }
+    }
+
+    static void unlink(const std::string &name) { shm_unlink(name.c_str()); }
+
+    bool valid() const { return shm != nullptr; }
+
+    // producer only: write the next frame and wake blocked readers, returns its sequence number
+    uint64_t publish(const T &frame) {
+        Header &h = shm->header;
+        uint64_t seq = h.writeSeq.load(std::memory_order_relaxed) + 1;
+        Slot &slot = shm->slots[seq & (N - 1)];
+
+        slot.version.store(2 * seq - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(static_cast<void *>(&slot.data), &frame, sizeof(T));
+        slot.version.store(2 * seq, std::memory_order_release);
+        h.writeSeq.store(seq, std::memory_order_seq_cst);
+
+        h.futexWord.fetch_add(1, std::memory_order_seq_cst);
+        if (h.waiters.load(std::memory_order_seq_cst) > 0)
+            futex(&h.futexWord, FUTEX_WAKE, INT_MAX, nullptr);
+        return seq;
+    }
+
+    // sequence number of the newest complete frame, 0 if nothing was published
+    uint64_t latestSeq() const { return shm->header.writeSeq.load(std::memory_order_acquire); }
+
+    // copy frame seq into out
+    ReadStatus read(uint64_t seq, T &out) const {
+        const Slot &slot = shm->slots[seq & (N - 1)];
+        uint64_t v1 = slot.version.load(std::memory_order_acquire);
+        if (v1 < 2 * seq)
+            return ReadNoData;
+        if (v1 > 2 * seq)
+            return ReadLapped;
+        memcpy(&out, static_cast<const void *>(&slot.data), sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t v2 = slot.version.load(std::memory_order_relaxed);
+        return v2 == v1 ? ReadOk : ReadLapped;
+    }
+
+    // copy the newest frame, returns false if nothing was published yet
+    bool readLatest(T &out, uint64_t &seq) const {
+        while (true) {
+            seq = latestSeq();
+            if (seq == 0)
+                return false;
+            if (read(seq, out) == ReadOk)
+                return true;
+            // overwritten while copying, a newer frame is there already
+        }
+    }
+
+    // copy the next unread frame of this reader, skipping (and counting) frames that were overwritten,
+    // returns false if the reader is up to date
+    bool readNext(Cursor &cursor, T &out, uint64_t &seq) const {
+        while (true) {
+            uint64_t latest = latestSeq();
+            if (latest + 1 < cursor.next)
+                cursor.next = 1;    // producer restarted the ring
+            if (cursor.next > latest)
+                return false;
+            if (latest - cursor.next >= N) {
+                uint64_t oldest = latest - N + 1;
+                cursor.dropped += oldest - cursor.next;
+                cursor.next = oldest;
+            }
+            seq = cursor.next;
+            ReadStatus status = read(seq, out);
+            if (status == ReadOk) {
+                cursor.next = seq + 1;
+                return true;
+            }
+            if (status == ReadNoData)
+                return false;
+            cursor.dropped++;
+            cursor.next = seq + 1;
+        }
+    }
+
+    // block until a frame newer than seq is published or timeoutNs elapsed (< 0: no timeout),
+    // returns true if a newer frame is available
+    bool waitNewer(uint64_t seq, int64_t timeoutNs = -1) const {
+        Header &h = shm->header;
+        struct timespec ts;
+        struct timespec *tsPtr = nullptr;
+        if (timeoutNs >= 0) {
+            ts.tv_sec = timeoutNs / 1000000000;
+            ts.tv_nsec = timeoutNs % 1000000000;
+            tsPtr = &ts;
+        }
+        if (latestSeq() > seq)
+            return true;
+        h.waiters.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t word = h.futexWord.load(std::memory_order_seq_cst);
+        if (latestSeq() <= seq)
+            futex(&h.futexWord, FUTEX_WAIT, word, tsPtr);
+        h.waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return latestSeq() > seq;
+    }
+
+private:
+    static const uint32_t magicValue = 0x4f4c5352;  // "OLSR"
+
+    struct alignas(64) Header {
+        std::atomic<uint32_t> magic;      // written last by create()
+        uint32_t capacity;
+        uint32_t frameSize;
+        std::atomic<uint64_t> writeSeq;
+        std::atomic<uint32_t> futexWord;    // bumped on every publish, readers sleep on it
+        std::atomic<uint32_t> waiters;      // readers currently blocked, producer skips the wake syscall if 0
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> version;
+        T data;
+    };
+
+    struct Layout {
+        Header header;
+        Slot slots[N];
+    };
+
+    Layout *shm{nullptr};
+
+    bool map(int fd) {
+        void *mem = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            perror("mmap failed");
+            return false;
+        }
+        shm = static_cast<Layout *>(mem);
+        return true;
+    }
+
+    static long futex(std::atomic<uint32_t> *addr, int op, uint32_t val, const struct timespec *timeout) {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), op, val, timeout, nullptr, 0);
+    }
+};
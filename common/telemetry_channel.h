@@ -0,0 +1,130 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Fixed-layout binary telemetry channel for the foxglove websocket server.
+// A channel is a flat list of float64/bool fields, published with the "ros1" message encoding and a "ros1msg"
+// schema, which foxglove decodes natively: little-endian values back to back, bool as one byte. Field offsets are
+// fixed when the channel is built, so write() only copies the values into a payload buffer that is allocated once
+// and reused for every message. tick() decimates the publishing rate per channel.
+// The websocket server thread may count subscribers and change the decimation while another thread publishes,
+// subscribed() lets the publisher skip encoding for channels nobody listens to.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <stdexcept>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "ros1 encoding is little-endian");
+
+class TelemetryChannel {
+public:
+    enum class FieldType : uint8_t { Float64, Bool };
+
+    struct Field {
+        std::string name;
+        FieldType type;
+    };
+
+    // decimation: publish every decimation-th tick, 1 publishes every tick
+    TelemetryChannel(std::string topic, std::string schemaName, std::vector<Field> fields, unsigned decimation = 1)
+        : topicName(std::move(topic)), schemaTypeName(std::move(schemaName)), fieldList(std::move(fields)) {
+        setDecimation(decimation);
+        size_t offset = 0;
+        for (const Field &f : fieldList) {
+            offsets.push_back(offset);
+            offset += f.type == FieldType::Float64 ? sizeof(double) : 1;
+        }
+        payload.assign(offset, 0);
+    }
+
+    const std::string &topic() const { return topicName; }
+    const std::string &schemaName() const { return schemaTypeName; }
+    static const char *encoding() { return "ros1"; }
+    static const char *schemaEncoding() { return "ros1msg"; }
+
+    // ros1msg definition, one "type name" line per field
+    std::string schema() const {
+        std::string text;
+        for (const Field &f : fieldList)
+            text += (f.type == FieldType::Float64 ? "float64 " : "bool ") + f.name + "\n";
+        return text;
+    }
+
+    // safe to call while another thread publishes, takes effect on the next tick()
+    void setDecimation(unsigned decimation) {
+        if (decimation == 0)
+            throw std::invalid_argument("Telemetry decimation must be positive");
+        every.store(decimation, std::memory_order_relaxed);
+    }
+    unsigned decimation() const { return every.load(std::memory_order_relaxed); }
+
+    // call once per loop tick, true on the ticks to publish (the first tick included)
+    bool tick() {
+        const bool due = phase == 0;
+        phase = phase + 1 >= every.load(std::memory_order_relaxed) ? 0 : phase + 1;
+        return due;
+    }
+
+    // subscriber count, kept by the server subscribe/unsubscribe handlers
+    void subscribe() { subscriberNum.fetch_add(1, std::memory_order_relaxed); }
+    void unsubscribe() {
+        int num = subscriberNum.load(std::memory_order_relaxed);
+        while (num > 0 && !subscriberNum.compare_exchange_weak(num, num - 1, std::memory_order_relaxed)) {
+        }
+    }
+    int subscribers() const { return subscriberNum.load(std::memory_order_relaxed); }
+    bool subscribed() const { return subscribers() > 0; }
+
+    void set(size_t idx, double value) {
+        check(idx, FieldType::Float64);
+        std::memcpy(payload.data() + offsets[idx], &value, sizeof(double));
+    }
+
+    void set(size_t idx, bool value) {
+        check(idx, FieldType::Bool);
+        payload[offsets[idx]] = value ? 1 : 0;
+    }
+
+    // all fields in declaration order, e.g. write(simTime, isContact, probability)
+    template<typename... Values>
+    void write(Values... values) {
+        if (sizeof...(Values) != fieldList.size())
+            throw std::invalid_argument("Telemetry write needs one value per field of " + topicName);
+        size_t idx = 0;
+        (setValue(idx++, values), ...);
+        messages++;
+    }
+
+    const uint8_t *data() const { return payload.data(); }
+    size_t size() const { return payload.size(); }
+    uint64_t written() const { return messages; }
+
+private:
+    std::string topicName;
+    std::string schemaTypeName;
+    std::vector<Field> fieldList;
+    std::vector<size_t> offsets;
+    std::vector<uint8_t> payload;
+    std::atomic<unsigned> every{1};
+    unsigned phase{0};
+    std::atomic<int> subscriberNum{0};
+    uint64_t messages{0};
+
+    void check(size_t idx, FieldType type) const {
+        if (idx >= fieldList.size() || fieldList[idx].type != type)
+            throw std::invalid_argument("Telemetry field type mismatch on " + topicName);
+    }
+
+    void setValue(size_t idx, bool value) { set(idx, value); }
+    template<typename T>
+    void setValue(size_t idx, T value) { set(idx, static_cast<double>(value)); }
+};
@@ -0,0 +1,162 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Moves telemetry (websocket publishing, log formatting) out of a control or detection loop.
+// The loop push()es plain samples into a single-producer/single-consumer ring of N slots, a publisher thread drains
+// the ring in batches and hands them to a sink that encodes and sends them. push() is wait-free: it never blocks on
+// the publisher, a full ring overwrites the oldest sample (drop-oldest backpressure) and the publisher counts every
+// sample it lost. Every slot is protected by a seqlock, the same scheme as ShmSeqlockRing but in process memory.
+// Losing samples is fine for live streams only, not for recorded data: DataLogger keeps its synchronous
+// finishLine() (quill already writes asynchronously), record/datalog.log must have every tick.
+//
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <functional>
+#include <exception>
+#include <type_traits>
+
+template<typename T, uint32_t N>
+class SeqlockQueue {
+    static_assert(std::is_trivially_copyable<T>::value, "queue samples are copied with memcpy");
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "queue size must be a power of two");
+
+public:
+    SeqlockQueue() : slots(N) {}
+    SeqlockQueue(const SeqlockQueue &) = delete;
+    SeqlockQueue &operator=(const SeqlockQueue &) = delete;
+
+    // producer only, overwrites the oldest sample when the consumer is N behind
+    void push(const T &sample) {
+        uint64_t seq = writeSeq.load(std::memory_order_relaxed) + 1;
+        Slot &slot = slots[seq & (N - 1)];
+        slot.version.store(2 * seq - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(static_cast<void *>(&slot.data), &sample, sizeof(T));
+        slot.version.store(2 * seq, std::memory_order_release);
+        writeSeq.store(seq, std::memory_order_release);
+    }
+
+    // consumer only: copy the next sample, skipping (and counting) overwritten ones, false if up to date
+    bool pop(T &out) {
+        while (true) {
+            uint64_t latest = writeSeq.load(std::memory_order_acquire);
+            if (next > latest)
+                return false;
+            if (latest - next >= N) {
+                lost += latest - N + 1 - next;
+                next = latest - N + 1;
+            }
+            const Slot &slot = slots[next & (N - 1)];
+            uint64_t v1 = slot.version.load(std::memory_order_acquire);
+            if (v1 == 2 * next) {
+                memcpy(&out, static_cast<const void *>(&slot.data), sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.version.load(std::memory_order_relaxed) == v1) {
+                    next++;
+                    return true;
+                }
+            } else if (v1 < 2 * next) {
+                return false;   // not complete yet
+            }
+            lost++;             // overwritten before or while copying
+            next++;
+        }
+    }
+
+    uint64_t pushed() const { return writeSeq.load(std::memory_order_acquire); }
+    uint64_t dropped() const { return lost; }   // consumer side count
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> version{0};
+        T data;
+    };
+
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<uint64_t> writeSeq{0};
+    alignas(64) uint64_t next{1};
+    uint64_t lost{0};
+};
+
+template<typename T, uint32_t N = 1024>
+class TelemetryPublisher {
+public:
+    // sink(samples, n) runs on the publisher thread, n <= maxBatch, samples in push order
+    using Sink = std::function<void(const T *samples, size_t n)>;
+
+    // idleUs: sleep of the publisher thread when the ring is empty, bounds the publishing delay
+    explicit TelemetryPublisher(Sink sink, size_t maxBatch = 64, uint32_t idleUs = 1000)
+        : sinkFunc(std::move(sink)), batch(maxBatch > 0 ? maxBatch : 1), idle(idleUs) {}
+    TelemetryPublisher(const TelemetryPublisher &) = delete;
+    TelemetryPublisher &operator=(const TelemetryPublisher &) = delete;
+    ~TelemetryPublisher() { stop(); }
+
+    void start() {
+        if (worker.joinable())
+            return;
+        running.store(true, std::memory_order_release);
+        worker = std::thread([this]() { run(); });
+    }
+
+    // drains what is left in the ring, then joins the publisher thread
+    void stop() {
+        if (!worker.joinable())
+            return;
+        running.store(false, std::memory_order_release);
+        worker.join();
+    }
+
+    // loop side, wait-free
+    void push(const T &sample) { queue.push(sample); }
+
+    uint64_t pushed() const { return queue.pushed(); }
+    uint64_t sent() const { return sentCount.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint64_t batches() const { return batchCount.load(std::memory_order_relaxed); }
+    uint64_t sinkErrors() const { return errorCount.load(std::memory_order_relaxed); }
+
+private:
+    SeqlockQueue<T, N> queue;
+    Sink sinkFunc;
+    std::vector<T> batch;
+    std::chrono::microseconds idle;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> sentCount{0}, droppedCount{0}, batchCount{0}, errorCount{0};
+
+    void run() {
+        while (true) {
+            const bool stopping = !running.load(std::memory_order_acquire);
+            size_t n = 0;
+            while (n < batch.size() && queue.pop(batch[n]))
+                n++;
+            droppedCount.store(queue.dropped(), std::memory_order_relaxed);
+            if (n > 0) {
+                try {
+                    sinkFunc(batch.data(), n);
+                } catch (const std::exception &e) {
+                    if (errorCount.fetch_add(1, std::memory_order_relaxed) == 0)
+                        fprintf(stderr, "telemetry sink failed: %s\n", e.what());
+                }
+                sentCount.fetch_add(n, std::memory_order_relaxed);
+                batchCount.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (stopping)
+                break;
+            std::this_thread::sleep_for(idle);
+        }
+    }
+};
@@ -0,0 +1,105 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Work-stealing parallel loop for offline tools (replay, parameter sweeps), not for the control loop.
+// parallelFor(n, task) deals the indices 0..n-1 round-robin into one deque per worker. A worker takes tasks from
+// the front of its own deque and, once that is empty, steals from the back of the others, so uneven task costs
+// are balanced without a shared queue. Exceptions thrown by a task are rethrown by parallelFor after all workers
+// have stopped.
+//
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <algorithm>
+
+class WorkStealingPool {
+public:
+    // threads == 0 uses one worker per hardware thread
+    explicit WorkStealingPool(unsigned threads = 0)
+        : threadNum(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+    unsigned size() const { return threadNum; }
+    size_t stolen() const { return stealCount; }   // tasks run by another worker than the one they were dealt to
+
+    // task(index, worker), worker in [0, size()) so per-worker state can be kept without locking
+    void parallelFor(size_t n, const std::function<void(size_t, unsigned)> &task) {
+        const unsigned workers = static_cast<unsigned>(std::min<size_t>(threadNum, std::max<size_t>(n, 1)));
+        std::vector<Queue> queues(workers);
+        for (size_t i = 0; i < n; i++)
+            queues[i % workers].tasks.push_back(i);
+
+        std::atomic<size_t> steals{0};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        std::atomic<bool> failed{false};
+        auto run = [&](unsigned w) {
+            size_t idx;
+            while (!failed.load(std::memory_order_relaxed)) {
+                if (!queues[w].popFront(idx)) {
+                    bool found = false;
+                    for (unsigned k = 1; k < workers && !found; k++)
+                        found = queues[(w + k) % workers].popBack(idx);
+                    if (!found)
+                        break;
+                    steals++;
+                }
+                try {
+                    task(idx, w);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error)
+                        error = std::current_exception();
+                    failed = true;
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned w = 1; w < workers; w++)
+            threads.emplace_back(run, w);
+        run(0);
+        for (auto &t : threads)
+            t.join();
+        stealCount = steals;
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+
+        bool popFront(size_t &idx) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+                return false;
+            idx = tasks.front();
+            tasks.pop_front();
+            return true;
+        }
+
+        bool popBack(size_t &idx) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
+                return false;
+            idx = tasks.back();
+            tasks.pop_back();
+            return true;
+        }
+    };
+
+    unsigned threadNum;
+    size_t stealCount{0};
+};
@@ -0,0 +1,296 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Contact_Estimator.h"
+#include "datalog_reader.h"
+#include "latency_stats.h"
+
+// Offline replay of DataLogger logs through the contact estimation pipeline, no MuJoCo or websocket needed.
+// Every log is replayed by its own ContactEstimator, logs are spread over worker threads.
+// Ground truth is lFtouch/rFtouch >= touch_threshold, reported per foot and in total:
+//   precision/recall of is_contact, touchdown latency (truth rises -> is_contact rises) and
+//   liftoff latency (truth falls -> is_contact falls), touchdowns missed while truth was high.
+// usage: ./contact_replay [-j threads] [--model gt2fcm.json] [--fis stable_contact_fis.json] [--compiled]
+//                         [--script matlabReadDataScript.txt] [--dump-inputs prefix [--dump-every n]] [datalog.log ...]
+// without logs ../record/datalog.log is replayed, the script defaults to the one next to each log.
+// --dump-inputs writes the inputs of the models of every n-th tick and every foot of one log, as replay sets for
+// contact_speed_test and fis_speed_test: prefix_gt2fcm.txt (5 normalized GT2FCM inputs per line) and
+// prefix_it2fis.txt (GT2FCM probability, h_disp, h_vel, ang_vel per line).
+
+struct FootStats {
+    size_t tp{0}, fp{0}, fn{0}, tn{0};
+    size_t touchdowns{0}, missedTouchdowns{0};
+    LatencyStats touchdownLatency{20000};   // ms
+    LatencyStats liftoffLatency{20000};     // ms
+
+    void merge(const FootStats& o) {
+        tp += o.tp; fp += o.fp; fn += o.fn; tn += o.tn;
+        touchdowns += o.touchdowns;
+        missedTouchdowns += o.missedTouchdowns;
+        touchdownLatency.merge(o.touchdownLatency);
+        liftoffLatency.merge(o.liftoffLatency);
+    }
+};
+
+struct ReplayResult {
+    std::string file;
+    std::string error;
+    size_t rows{0}, skipped{0}, bytes{0};
+    int feet{0};
+    double seconds{0};
+    std::array<FootStats, 2> foot;
+};
+
+struct ReplayOptions {
+    std::string script;
+    std::string model;
+    std::string fis;
+    bool compiled{false};
+    std::string dumpPrefix;
+    size_t dumpEvery{1};
+    // configured (and compiled) estimators for one and two feet, copied for every log
+    std::vector<ContactEstimator> prototype;
+};
+
+// follows one foot's truth and estimate edges
+struct EdgeTracker {
+    bool truth{false}, est{false};
+    bool waitTouchdown{false}, waitLiftoff{false};
+    double tTruthRise{0}, tTruthFall{0};
+
+    void update(bool truthNow, bool estNow, double t, FootStats& s) {
+        if (truthNow && estNow) s.tp++;
+        else if (!truthNow && estNow) s.fp++;
+        else if (truthNow && !estNow) s.fn++;
+        else s.tn++;
+
+        if (truthNow && !truth) {
+            s.touchdowns++;
+            tTruthRise = t;
+            waitTouchdown = true;
+            waitLiftoff = false;
+        } else if (!truthNow && truth) {
+            if (waitTouchdown)
+                s.missedTouchdowns++;
+            waitTouchdown = false;
+            tTruthFall = t;
+            waitLiftoff = true;
+        }
+        if (waitTouchdown && estNow) {
+            s.touchdownLatency.add((t - tTruthRise) * 1e3);
+            waitTouchdown = false;
+        }
+        if (waitLiftoff && !estNow) {
+            s.liftoffLatency.add((t - tTruthFall) * 1e3);
+            waitLiftoff = false;
+        }
+        truth = truthNow;
+        est = estNow;
+    }
+};
+
+static void replayFile(const std::string& file, const ReplayOptions& opt, ReplayResult& res) {
+    res.file = file;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        DataLogReader log(file, opt.script);
+        const bool right = log.hasItem("rFtouch");
+        res.feet = right ? 2 : 1;
+
+        ContactEstimator estimator = opt.prototype[res.feet - 1];
+
+        // column of every field, per foot
+        const char* prefix[2] = {"lF", "rF"};
+        const int motorCol = log.itemColumn("motor_pos_cur");
+        const int timeCol = log.hasItem("simTime") ? log.itemColumn("simTime") : -1;
+        int posCol[2], rpyCol[2], angVelCol[2], velCol[2], accCol[2], contactCol[2], touchCol[2];
+        int hipCol[2], kneeCol[2];
+        for (int f = 0; f < res.feet; f++) {
+            const std::string p = prefix[f];
+            posCol[f] = log.itemColumn(p + "gpsVal");
+            rpyCol[f] = log.itemColumn(p + "rpyVal");
+            angVelCol[f] = log.itemColumn(p + "_AngVel");
+            velCol[f] = log.itemColumn(p + "_vel");
+            accCol[f] = log.itemColumn(p + "_acc");
+            contactCol[f] = log.hasItem(p + "contact") ? log.itemColumn(p + "contact") : -1;
+            touchCol[f] = log.itemColumn(p + "touch");
+            // DataBus::q holds 7 base coordinates before the motors
+            hipCol[f] = motorCol + estimator.hipJointIdx[f] - 7;
+            kneeCol[f] = motorCol + estimator.kneeJointIdx[f] - 7;
+            if (estimator.hipJointIdx[f] < 7 || estimator.kneeJointIdx[f] < 7 ||
+                std::max(hipCol[f], kneeCol[f]) >= motorCol + log.itemLength("motor_pos_cur"))
+                throw std::runtime_error("hip/knee joint index outside motor_pos_cur");
+        }
+
+        std::vector<double> row(log.columns());
+        std::vector<ContactSensorFrame> frames(res.feet);
+        EdgeTracker tracker[2];
+        size_t tick = 0;
+
+        FILE* dumpGT2FCM = nullptr;
+        FILE* dumpIT2FIS = nullptr;
+        if (!opt.dumpPrefix.empty()) {
+            dumpGT2FCM = fopen((opt.dumpPrefix + "_gt2fcm.txt").c_str(), "w");
+            dumpIT2FIS = fopen((opt.dumpPrefix + "_it2fis.txt").c_str(), "w");
+            if (!dumpGT2FCM || !dumpIT2FIS)
+                throw std::runtime_error("cannot write " + opt.dumpPrefix + "_*.txt");
+            fprintf(dumpGT2FCM, "# %s, every %zu ticks, feet interleaved: normalized GT2FCM input\n",
+                    file.c_str(), opt.dumpEvery);
+            fprintf(dumpIT2FIS, "# %s, every %zu ticks, feet interleaved: probability h_disp h_vel ang_vel\n",
+                    file.c_str(), opt.dumpEvery);
+        }
+        while (log.nextRow(row.data())) {
+            for (int f = 0; f < res.feet; f++) {
+                ContactSensorFrame& fr = frames[f];
+                for (int i = 0; i < 3; i++) {
+                    fr.pos[i] = row[posCol[f] + i];
+                    fr.rpy[i] = row[rpyCol[f] + i];
+                    fr.angular_vel[i] = row[angVelCol[f] + i];
+                    fr.linear_vel[i] = row[velCol[f] + i];
+                    fr.acc[i] = row[accCol[f] + i];
+                }
+                fr.hip_joint_pos = row[hipCol[f]];
+                fr.knee_joint_pos = row[kneeCol[f]];
+                fr.touch = row[touchCol[f]];
+                for (int i = 0; i < 4; i++)
+                    fr.corner_touch[i] = contactCol[f] >= 0 ? row[contactCol[f] + i] : 0.0;
+            }
+            estimator.step(frames.data());
+
+            const double t = timeCol >= 0 ? row[timeCol] : tick * 0.001;
+            for (int f = 0; f < res.feet; f++) {
+                const ContactEstimate& est = estimator.getEstimate(f);
+                tracker[f].update(est.contact_truth, est.is_contact, t, res.foot[f]);
+                if (dumpGT2FCM && tick % opt.dumpEvery == 0) {
+                    const auto& x = est.input_normalized;
+                    fprintf(dumpGT2FCM, "%.9g %.9g %.9g %.9g %.9g\n", x[0], x[1], x[2], x[3], x[4]);
+                    fprintf(dumpIT2FIS, "%.9g %.9g %.9g %.9g\n", est.probability, est.it2fis_input[0],
+                            est.it2fis_input[1], est.it2fis_input[2]);
+                }
+            }
+            tick++;
+        }
+        if (dumpGT2FCM) {
+            fclose(dumpGT2FCM);
+            fclose(dumpIT2FIS);
+        }
+        res.rows = log.rowsRead();
+        res.skipped = log.rowsSkipped();
+        res.bytes = log.bytes();
+    } catch (const std::exception& e) {
+        res.error = e.what();
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printFoot(const char* name, const FootStats& s) {
+    const double precision = (s.tp + s.fp) ? double(s.tp) / (s.tp + s.fp) : 0.0;
+    const double recall = (s.tp + s.fn) ? double(s.tp) / (s.tp + s.fn) : 0.0;
+    printf("  %-5s precision %.4f recall %.4f  (tp %zu fp %zu fn %zu tn %zu)\n",
+           name, precision, recall, s.tp, s.fp, s.fn, s.tn);
+    printf("        touchdowns %zu, missed %zu, latency mean %.1f ms p50 %.1f p95 %.1f max %.1f\n",
+           s.touchdowns, s.missedTouchdowns, s.touchdownLatency.mean(), s.touchdownLatency.percentile(50),
+           s.touchdownLatency.percentile(95), s.touchdownLatency.max());
+    printf("        liftoffs %zu, latency mean %.1f ms p50 %.1f p95 %.1f max %.1f\n",
+           s.liftoffLatency.count(), s.liftoffLatency.mean(), s.liftoffLatency.percentile(50),
+           s.liftoffLatency.percentile(95), s.liftoffLatency.max());
+}
+
+int main(int argc, const char **argv) {
+    ReplayOptions opt;
+    std::vector<std::string> files;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc)
+            opt.model = argv[++i];
+        else if (!strcmp(argv[i], "--fis") && i + 1 < argc)
+            opt.fis = argv[++i];
+        else if (!strcmp(argv[i], "--script") && i + 1 < argc)
+            opt.script = argv[++i];
+        else if (!strcmp(argv[i], "--compiled"))
+            opt.compiled = true;
+        else if (!strcmp(argv[i], "--dump-inputs") && i + 1 < argc)
+            opt.dumpPrefix = argv[++i];
+        else if (!strcmp(argv[i], "--dump-every") && i + 1 < argc)
+            opt.dumpEvery = std::max(1, atoi(argv[++i]));
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty())
+        files.push_back("../record/datalog.log");
+    if (!opt.dumpPrefix.empty() && files.size() > 1) {
+        std::cerr << "[replay] --dump-inputs takes one log" << std::endl;
+        return 1;
+    }
+    threads = std::min<unsigned>(threads, files.size());
+
+    try {
+        for (int feet = 1; feet <= 2; feet++) {
+            opt.prototype.emplace_back(feet, 100);
+            ContactEstimator& estimator = opt.prototype.back();
+            if (!opt.model.empty())
+                estimator.loadModel(opt.model.c_str());
+            if (!opt.fis.empty())
+                estimator.setStableFIS(opt.fis.c_str());
+            if (opt.compiled)
+                estimator.compile();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[replay] " << e.what() << std::endl;
+        return 1;
+    }
+
+    // workers take the next log until all are done
+    std::vector<ReplayResult> results(files.size());
+    std::atomic<size_t> next{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned w = 0; w < threads; w++) {
+        workers.emplace_back([&]() {
+            for (size_t k = next++; k < files.size(); k = next++)
+                replayFile(files[k], opt, results[k]);
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::array<FootStats, 2> total;
+    size_t rows = 0, bytes = 0, failed = 0;
+    for (const ReplayResult& res : results) {
+        if (!res.error.empty()) {
+            printf("[replay] %s: %s\n", res.file.c_str(), res.error.c_str());
+            failed++;
+            continue;
+        }
+        printf("[replay] %s: %zu ticks (%zu lines skipped), %.2f s, %.0f ticks/s\n", res.file.c_str(),
+               res.rows, res.skipped, res.seconds, res.rows / std::max(res.seconds, 1e-9));
+        printFoot("left", res.foot[0]);
+        if (res.feet > 1)
+            printFoot("right", res.foot[1]);
+        for (int f = 0; f < res.feet; f++)
+            total[f].merge(res.foot[f]);
+        rows += res.rows;
+        bytes += res.bytes;
+    }
+    if (results.size() - failed > 1) {
+        printf("[replay] total: %zu logs, %zu ticks, %.1f MB\n", results.size() - failed, rows, bytes / 1e6);
+        printFoot("left", total[0]);
+        printFoot("right", total[1]);
+    }
+    printf("[replay] %u threads, wall %.2f s, %.0f ticks/s%s\n", threads, wall, rows / std::max(wall, 1e-9),
+           opt.compiled ? ", compiled mode" : "");
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,540 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <deque>
+
+#include "GT2FIS_Contact.h"
+#include "GT2FIS_Contact_Fixed.h"
+#include "GT2FIS_Default_Model.h"
+#include "Contact_Estimator.h"
+#include "IT2FIS_Stable_Contact.h"
+#include "Data_Filter.h"
+
+// Speed test of the contact detection pipeline, no simulation needed.
+// Inputs are random normalized samples, the model is the shipped left foot model.
+// usage: ./contact_speed_test [recorded_inputs.txt]
+// the optional file holds one normalized GT2FCM input (5 columns) per line and is
+// replayed through the membership regression check.
+
+static const int numRules = 13;
+static const int inputDim = 5;
+static const int numMF = 7;
+
+static std::vector<std::array<double, inputDim>> makeInputs(size_t n) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<std::array<double, inputDim>> inputs(n);
+    for (auto& x : inputs)
+        for (auto& v : x)
+            v = dist(gen);
+    return inputs;
+}
+
+// recorded GT2FCM inputs, one sample of inputDim values per line
+static std::vector<std::array<double, inputDim>> loadInputs(const char* fileName) {
+    std::vector<std::array<double, inputDim>> inputs;
+    std::ifstream file(fileName);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::array<double, inputDim> x;
+        int k = 0;
+        while (k < inputDim && (ss >> x[k]))
+            k++;
+        if (k == inputDim)
+            inputs.push_back(x);
+    }
+    return inputs;
+}
+
+// best of several runs, in ns per call
+template<typename Func>
+static double timePerCall(size_t n, Func&& func, int repeat = 5) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t k = 0; k < n; k++)
+            func(k);
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / n);
+    }
+    return best;
+}
+
+// GT2FCM (heap vectors) vs GT2FCM_Fixed (flat UNR, stack scratch)
+static void speedTestGT2FCM(const std::vector<std::array<double, inputDim>>& inputs) {
+    GT2FCM fuzzyModel(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numRules, inputDim, numMF);
+    GT2FCM_Fixed<numRules, inputDim> fuzzyModelFixed(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numMF);
+
+    const size_t n = inputs.size();
+    std::vector<double> outRef(n), outFixed(n);
+    std::vector<double> inputData(inputDim);
+
+    double tRef = timePerCall(n, [&](size_t k) {
+        inputData.assign(inputs[k].begin(), inputs[k].end());
+        outRef[k] = fuzzyModel.calculate(inputData);
+    });
+    double tFixed = timePerCall(n, [&](size_t k) {
+        outFixed[k] = fuzzyModelFixed.calculate(inputs[k]);
+    });
+
+    double maxErr = 0;
+    for (size_t k = 0; k < n; k++)
+        maxErr = std::max(maxErr, std::abs(outRef[k] - outFixed[k]));
+
+    printf("[GT2FCM] samples: %zu\n", n);
+    printf("  GT2FCM::calculate        : %8.1f ns/call\n", tRef);
+    printf("  GT2FCM_Fixed::calculate  : %8.1f ns/call (x%.2f)\n", tFixed, tRef / tFixed);
+    printf("  max |diff|               : %.3e\n", maxErr);
+}
+
+// GT2FCM::calculateBatch (SoA + Eigen SIMD) vs the scalar per-sample loop
+static void speedTestBatch(const std::vector<std::array<double, inputDim>>& inputs) {
+    GT2FCM fuzzyModel(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numRules, inputDim, numMF);
+
+    const size_t n = inputs.size();
+    std::vector<double> outRef(n), outBatch(n);
+    std::vector<double> inputData(inputDim);
+
+    double tRef = timePerCall(n, [&](size_t k) {
+        inputData.assign(inputs[k].begin(), inputs[k].end());
+        outRef[k] = fuzzyModel.calculate(inputData);
+    });
+    double tBatch = timePerCall(1, [&](size_t) {
+        fuzzyModel.calculateBatch(inputs[0].data(), n, outBatch.data());
+    }) / n;
+
+    double maxErr = 0;
+    for (size_t k = 0; k < n; k++)
+        maxErr = std::max(maxErr, std::abs(outRef[k] - outBatch[k]));
+
+    printf("[GT2FCM batch] samples: %zu\n", n);
+    printf("  scalar loop              : %8.2f Msamples/s\n", 1e3 / tRef);
+    printf("  calculateBatch           : %8.2f Msamples/s (x%.2f)\n", 1e3 / tBatch, tRef / tBatch);
+    printf("  max |diff|               : %.3e\n", maxErr);
+}
+
+// full contact pipeline per control tick for several end-effectors
+static void speedTestEstimator(int numEndEffectors, size_t tickNum) {
+    ContactEstimator estimator(numEndEffectors, 100);
+    std::mt19937 gen(7);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    // synthetic gait: feet alternate between stance and swing every 0.4 s
+    std::vector<std::vector<ContactSensorFrame>> frames(tickNum, std::vector<ContactSensorFrame>(numEndEffectors));
+    for (size_t k = 0; k < tickNum; k++) {
+        for (int i = 0; i < numEndEffectors; i++) {
+            ContactSensorFrame& f = frames[k][i];
+            bool stance = ((k / 400) + i) % 2 == 0;
+            f.acc = {noise(gen), noise(gen), 9.81 + (stance ? 0.5 : 5.0) * noise(gen)};
+            f.rpy = {0.01 * noise(gen), 0.01 * noise(gen), 0.0};
+            f.linear_vel = {stance ? 0.0 : 0.8, 0.0, stance ? 0.0 : 0.3 * noise(gen)};
+            f.angular_vel = {0.1 * noise(gen), 0.1 * noise(gen), 0.1 * noise(gen)};
+            f.pos = {0.8 * 0.001 * k, 0.1 * i, stance ? 0.0 : 0.1};
+            f.hip_joint_pos = 0.3 * noise(gen);
+            f.knee_joint_pos = 0.6 + 0.3 * noise(gen);
+            f.touch = stance ? 300.0 : 0.0;
+        }
+    }
+
+    double tTick = timePerCall(tickNum, [&](size_t k) {
+        estimator.step(frames[k]);
+    }, 3);
+    printf("[ContactEstimator] end-effectors: %d, ticks: %zu\n", numEndEffectors, tickNum);
+    printf("  step                     : %8.2f us/tick (%.2f us per end-effector)\n",
+           tTick * 1e-3, tTick * 1e-3 / numEndEffectors);
+}
+
+// keeps the timed results alive
+static volatile double benchmarkSink = 0;
+
+// compiled (table) mode against the exact path: reported error, agreement on a synthetic gait, speed
+static void speedTestCompiled(size_t tickNum) {
+    std::mt19937 gen(11);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<ContactSensorFrame> frames(tickNum);
+    for (size_t k = 0; k < tickNum; k++) {
+        ContactSensorFrame& f = frames[k];
+        bool stance = (k / 400) % 2 == 0;
+        f.acc = {noise(gen), noise(gen), 9.81 + (stance ? 0.5 : 5.0) * noise(gen)};
+        f.rpy = {0.01 * noise(gen), 0.01 * noise(gen), 0.0};
+        f.linear_vel = {stance ? 0.0 : 0.8, 0.0, stance ? 0.0 : 0.3 * noise(gen)};
+        f.angular_vel = {0.1 * noise(gen), 0.1 * noise(gen), 0.1 * noise(gen)};
+        f.pos = {0.8 * 0.001 * k, 0.0, stance ? 0.0 : 0.1};
+        f.hip_joint_pos = 0.3 * noise(gen);
+        f.knee_joint_pos = 0.6 + 0.3 * noise(gen);
+    }
+
+    ContactEstimator exact(1, 100);
+    std::vector<ContactEstimate> ref(tickNum);
+    for (size_t k = 0; k < tickNum; k++) {
+        exact.step(&frames[k]);
+        ref[k] = exact.getEstimate(0);
+    }
+    exact.reset();
+    double tExact = timePerCall(tickNum, [&](size_t k) { exact.step(&frames[k]); }, 3);
+
+    printf("[compiled] ticks: %zu, exact step %.2f us/tick\n", tickNum, tExact * 1e-3);
+    for (auto res : {std::make_pair(5, 7), std::make_pair(9, 11), std::make_pair(13, 17)}) {
+        ContactEstimator estimator(1, 100);
+        auto start = std::chrono::high_resolution_clock::now();
+        estimator.compile(res.first, res.second);
+        auto end = std::chrono::high_resolution_clock::now();
+        const auto& err = estimator.compiledError();
+
+        double maxProb = 0, maxStable = 0;
+        size_t decisions = 0;
+        for (size_t k = 0; k < tickNum; k++) {
+            estimator.step(&frames[k]);
+            const ContactEstimate& est = estimator.getEstimate(0);
+            maxProb = std::max(maxProb, std::abs(est.probability - ref[k].probability));
+            maxStable = std::max(maxStable, std::abs(est.stable_probability - ref[k].stable_probability));
+            decisions += est.is_contact != ref[k].is_contact;
+        }
+        estimator.reset();
+        double t = timePerCall(tickNum, [&](size_t k) { estimator.step(&frames[k]); }, 3);
+        printf("  grid %2d^5 + %2d^4 (%6.0f kB, compile %.2f s): reported max (mean) err GT2FCM %.2e (%.1e) prob %.2e IT2FIS %.2e (%.1e) chain %.2e\n",
+               res.first, res.second, estimator.compiledMemoryBytes() / 1024.0,
+               std::chrono::duration<double>(end - start).count(),
+               err.gt2fcm, err.gt2fcmMean, err.probability, err.stableFIS, err.stableFISMean, err.pipeline);
+        printf("    gait max |diff| prob %.2e stable %.2e, contact decision differs %zu/%zu, step %.2f us/tick (x%.1f)\n",
+               maxProb, maxStable, decisions, tickNum, t * 1e-3, tExact / t);
+    }
+}
+
+// deque histories with statistics recomputed over the whole window, the way StableContactDetector
+// worked before the ring buffers
+struct StableContactReference {
+    size_t window;
+    std::deque<std::array<double, 3>> position;
+    std::deque<double> hVel, angVel, prob;
+
+    explicit StableContactReference(size_t w) : window(w) {}
+
+    void addFrame(bool contact, const std::array<double, 3>& pos, double hVel_, double angVel_, double p) {
+        hVel.push_back(hVel_);
+        angVel.push_back(angVel_);
+        prob.push_back(p);
+        if (hVel.size() > window) {
+            hVel.pop_front();
+            angVel.pop_front();
+            prob.pop_front();
+        }
+        position.push_back(pos);
+        if (!contact)
+            position.clear();
+        if (position.size() > window)
+            position.pop_front();
+    }
+    double displacement() const {
+        if (position.size() < 2)
+            return 0.0;
+        double dx = position.back()[0] - position.front()[0];
+        double dy = position.back()[1] - position.front()[1];
+        return sqrt(dx*dx + dy*dy);
+    }
+    static double mean(const std::deque<double>& d) {
+        return d.empty() ? 0.0 : std::accumulate(d.begin(), d.end(), 0.0) / d.size();
+    }
+    static double max(const std::deque<double>& d) { return d.empty() ? 0.0 : *std::max_element(d.begin(), d.end()); }
+    static double min(const std::deque<double>& d) { return d.empty() ? 0.0 : *std::min_element(d.begin(), d.end()); }
+};
+
+// StableContactDetector ring buffers + running statistics vs recomputing over deques, per frame:
+// addFrame + addWindowSample, horizontal displacement, mean/max horizontal velocity, mean/max angular velocity,
+// min probability. The window samples are the world-frame magnitudes ContactEstimator computes.
+static bool speedTestStableContact(size_t frameNum) {
+    std::mt19937 gen(11);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<std::array<double, 3>> pos(frameNum), vel(frameNum), angVel(frameNum);
+    std::vector<double> hVel(frameNum), angVelNorm(frameNum), prob(frameNum);
+    StableContactDetector frameTransform;
+    std::vector<char> contact(frameNum);
+    for (size_t k = 0; k < frameNum; k++) {
+        contact[k] = (k / 600) % 3 != 2;     // 1.2 s stance, 0.6 s swing
+        pos[k] = {0.001 * k + 1e-4 * noise(gen), 1e-4 * noise(gen), contact[k] ? 0.0 : 0.1};
+        vel[k] = {0.1 * noise(gen), 0.1 * noise(gen), 0.1 * noise(gen)};
+        angVel[k] = {noise(gen), noise(gen), noise(gen)};
+        prob[k] = contact[k] ? 0.9 + 0.05 * noise(gen) : 0.1 + 0.05 * noise(gen);
+        const std::array<double, 3> rpy{0.05 * noise(gen), 0.05 * noise(gen), 0.3};
+        hVel[k] = frameTransform.calculateHorizontalVelocityMagnitude(frameTransform.transformToWorldFrame(vel[k], rpy));
+        angVelNorm[k] = frameTransform.calculateAngularVelocityMagnitude(frameTransform.transformToWorldFrame(angVel[k], rpy));
+    }
+
+    bool pass = true;
+    printf("[StableContactDetector] frames: %zu\n", frameNum);
+    for (size_t window : {50, 100, 200, 500, 1000}) {
+        StableContactDetector detector(window);
+        StableContactReference reference(window);
+        double maxErr = 0, sink = 0;
+        for (size_t k = 0; k < frameNum; k++) {
+            detector.addFrame(contact[k], pos[k], vel[k], angVel[k], prob[k]);
+            detector.addWindowSample(hVel[k], angVelNorm[k], prob[k]);
+            reference.addFrame(contact[k], pos[k], hVel[k], angVelNorm[k], prob[k]);
+            maxErr = std::max(maxErr, std::abs(detector.calculateHorizontalDisplacement() - reference.displacement()));
+            maxErr = std::max(maxErr, std::abs(detector.meanHorizontalVelocity() - StableContactReference::mean(reference.hVel)));
+            maxErr = std::max(maxErr, std::abs(detector.maxHorizontalVelocity() - StableContactReference::max(reference.hVel)));
+            maxErr = std::max(maxErr, std::abs(detector.meanAngularVelocity() - StableContactReference::mean(reference.angVel)));
+            maxErr = std::max(maxErr, std::abs(detector.maxAngularVelocity() - StableContactReference::max(reference.angVel)));
+            maxErr = std::max(maxErr, std::abs(detector.minContactProbability() - StableContactReference::min(reference.prob)));
+        }
+
+        StableContactDetector detectorTimed(window);
+        StableContactReference referenceTimed(window);
+        double tRing = timePerCall(frameNum, [&](size_t k) {
+            detectorTimed.addFrame(contact[k], pos[k], vel[k], angVel[k], prob[k]);
+            detectorTimed.addWindowSample(hVel[k], angVelNorm[k], prob[k]);
+            sink += detectorTimed.calculateHorizontalDisplacement() + detectorTimed.meanHorizontalVelocity() +
+                    detectorTimed.maxHorizontalVelocity() + detectorTimed.meanAngularVelocity() +
+                    detectorTimed.maxAngularVelocity() + detectorTimed.minContactProbability();
+        }, 3);
+        double tRef = timePerCall(frameNum, [&](size_t k) {
+            referenceTimed.addFrame(contact[k], pos[k], hVel[k], angVelNorm[k], prob[k]);
+            sink += referenceTimed.displacement() + StableContactReference::mean(referenceTimed.hVel) +
+                    StableContactReference::max(referenceTimed.hVel) + StableContactReference::mean(referenceTimed.angVel) +
+                    StableContactReference::max(referenceTimed.angVel) + StableContactReference::min(referenceTimed.prob);
+        }, 3);
+
+        bool ok = maxErr <= 1e-12;
+        pass = pass && ok;
+        printf("  window %4zu: ring %7.1f ns/frame, deque recompute %8.1f ns/frame (x%.1f), max |diff| %.3e %s\n",
+               window, tRing, tRef, tRef / tRing, maxErr, ok ? "PASS" : "FAIL");
+        benchmarkSink = sink;
+    }
+    return pass;
+}
+
+// sort-based median of the original DataFilterNormalizer::applyMedianFilter
+static double medianBySort(double value, std::deque<double>& history, size_t window) {
+    history.push_back(value);
+    if (history.size() > window)
+        history.pop_front();
+    std::vector<double> values(history.begin(), history.end());
+    std::sort(values.begin(), values.end());
+    if (values.size() % 2 == 0)
+        return (values[values.size()/2 - 1] + values[values.size()/2]) / 2.0;
+    return values[values.size()/2];
+}
+
+// StreamingMedian vs copy-and-sort, outputs must be identical; then DataFilterNormalizer with the
+// acceleration median filter on and off
+static bool speedTestMedianFilter(size_t sampleNum) {
+    std::mt19937 gen(5);
+    std::normal_distribution<double> noise(0.0, 5.0);
+    std::vector<double> samples(sampleNum);
+    for (size_t k = 0; k < sampleNum; k++)   // quantized every third sample to get ties
+        samples[k] = (k % 3 == 0) ? std::round(noise(gen)) : noise(gen);
+
+    bool pass = true;
+    double sink = 0;
+    printf("[median filter] samples: %zu\n", sampleNum);
+    for (size_t window : {5, 15, 51, 101}) {
+        StreamingMedian median(window);
+        std::deque<double> history;
+        size_t mismatch = 0;
+        for (size_t k = 0; k < sampleNum; k++)
+            mismatch += median.add(samples[k]) != medianBySort(samples[k], history, window);
+
+        StreamingMedian medianTimed(window);
+        std::deque<double> historyTimed;
+        double tHeap = timePerCall(sampleNum, [&](size_t k) { sink += medianTimed.add(samples[k]); });
+        double tSort = timePerCall(sampleNum, [&](size_t k) { sink += medianBySort(samples[k], historyTimed, window); });
+
+        pass = pass && mismatch == 0;
+        printf("  window %3zu: two heaps %6.1f ns/sample, sort %7.1f ns/sample (x%.1f), mismatches %zu %s\n",
+               window, tHeap, tSort, tSort / tHeap, mismatch, mismatch == 0 ? "PASS" : "FAIL");
+    }
+
+    const std::array<double, 3> rpy{0.01, -0.02, 0.0};
+    for (bool accMedian : {false, true}) {
+        DataFilterNormalizer filter;
+        filter.median_filter_acc = accMedian;
+        double t = timePerCall(sampleNum / 3, [&](size_t k) {
+            std::array<double, 3> acc{samples[3 * k], samples[3 * k + 1], 9.81 + samples[3 * k + 2]};
+            sink += filter.processData(acc, rpy, 0.1 * samples[k], 0.1, 0.5)[0];
+        });
+        printf("  DataFilterNormalizer::processData, acc x/y/z median %-3s: %6.1f ns/sample\n",
+               accMedian ? "on" : "off", t);
+    }
+    benchmarkSink = sink;
+    return pass;
+}
+
+// P2Quantile against the sorted stream, then the normalization modes of DataFilterNormalizer:
+// a filter restored from a saved Percentile calibration has to match the warmed-up filter from the first tick
+static bool checkNormalization(size_t sampleNum) {
+    std::mt19937 gen(11);
+    std::normal_distribution<double> noise(0.0, 3.0);
+    std::vector<double> samples(sampleNum);
+    for (double& v : samples)
+        v = std::abs(noise(gen));
+
+    bool pass = true;
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    for (double p : {0.5, 0.9, 0.99}) {
+        P2Quantile sketch(p), resumed(p);
+        for (size_t k = 0; k < sampleNum; k++) {
+            sketch.add(samples[k]);
+            if (k == sampleNum / 2)
+                resumed.restore(sketch.state());
+            else if (k > sampleNum / 2)
+                resumed.add(samples[k]);
+        }
+        const double exact = sorted[static_cast<size_t>(p * (sampleNum - 1))];
+        const double relErr = std::abs(sketch.value() - exact) / exact;
+        const bool ok = relErr < 0.02 && resumed.value() == sketch.value();
+        pass = pass && ok;
+        printf("[normalization] P2 quantile p %.2f: %.4f, exact %.4f, rel. error %.2e, resumed %s %s\n",
+               p, sketch.value(), exact, relErr, resumed.value() == sketch.value() ? "same" : "differs",
+               ok ? "PASS" : "FAIL");
+    }
+
+    // walking-like signals, fed to a warmed-up filter, a cold one and one restored from the warm calibration
+    auto frame = [](size_t k, std::array<double, 3>& acc, double& vel, double& hip, double& knee) {
+        const double phase = 2.0 * M_PI * k * 0.001 * 1.7;
+        acc = {0.5 * sin(3 * phase), 0.3 * cos(2 * phase), 9.81 + 6.0 * sin(phase) * sin(phase) * (sin(phase) > 0)};
+        vel = 0.4 * cos(phase);
+        hip = 0.3 + 0.2 * sin(phase);
+        knee = -0.8 + 0.3 * cos(phase);
+    };
+    const std::array<double, 3> rpy{0.0, 0.0, 0.0};
+    const char* path = "contact_speed_test_calibration.json";
+    for (NormalizationMode mode : {NormalizationMode::Percentile, NormalizationMode::DecayingMax}) {
+        DataFilterNormalizer warm, cold, restored;
+        for (DataFilterNormalizer* f : {&warm, &cold, &restored})
+            f->setNormalizationMode(mode, 2.0, 0.95);
+        std::array<double, 3> acc;
+        double vel, hip, knee;
+        const size_t warmup = 20000;
+        for (size_t k = 0; k < warmup; k++) {
+            frame(k, acc, vel, hip, knee);
+            warm.processData(acc, rpy, vel, hip, knee);
+        }
+        DataFilterNormalizer::saveCalibration(path, warm.getCalibration());
+        restored.setCalibration(DataFilterNormalizer::loadCalibration(path));
+        std::remove(path);
+
+        // filter histories differ for the first ticks, the divisors must not
+        double coldErr = 0, restoredErr = 0;
+        const size_t ticks = 2000;
+        for (size_t k = warmup; k < warmup + ticks; k++) {
+            frame(k, acc, vel, hip, knee);
+            std::vector<double> w = warm.processData(acc, rpy, vel, hip, knee);
+            std::vector<double> c = cold.processData(acc, rpy, vel, hip, knee);
+            std::vector<double> r = restored.processData(acc, rpy, vel, hip, knee);
+            for (int i = 1; i < 4; i++) {   // inputs without the acceleration filter transient
+                coldErr = std::max(coldErr, std::abs(c[i] - w[i]));
+                restoredErr = std::max(restoredErr, std::abs(r[i] - w[i]));
+            }
+        }
+        const bool ok = restoredErr < 1e-6;
+        pass = pass && ok;
+        printf("[normalization] %s: first %zu ticks, max |output - warm| cold start %.3f, restored calibration %.2e %s\n",
+               mode == NormalizationMode::Percentile ? "percentile  " : "decaying max", ticks, coldErr, restoredErr,
+               ok ? "PASS" : "FAIL");
+    }
+    return pass;
+}
+
+// pairwise O(r^2) membership of the original GT2FCM, used as reference for the O(r) paths
+template<int Rules, int Dim>
+static double calculatePairwise(const GT2FCM_Fixed<Rules, Dim>& model, const double* x) {
+    const auto& UNR = model.getUNR();
+    const double m = model.getFcmConstant();
+    double dist[Rules], mu[Rules];
+    for (int i = 0; i < Rules; i++) {
+        double s = 0;
+        for (int n = 0; n < Dim; n++) {
+            double diff = x[n] - UNR[i * (Dim + 1) + n];
+            s += diff * diff;
+        }
+        dist[i] = s;
+    }
+    for (int i = 0; i < Rules; i++) {
+        double dist_i = (dist[i] < 1e-10) ? 1e-10 : dist[i];
+        double sum_ratio = 0;
+        for (int l = 0; l < Rules; l++)
+            sum_ratio += std::pow(dist[l] / dist_i, 1.0 / (m - 1.0));
+        mu[i] = sum_ratio;
+    }
+    double min_mu = *std::min_element(mu, mu + Rules);
+    double max_mu = *std::max_element(mu, mu + Rules);
+    double numerator = 0, denominator = 0;
+    for (int i = 0; i < Rules; i++) {
+        double C = (max_mu > min_mu) ? (mu[i] - min_mu) / (max_mu - min_mu) : 1.0 / Rules;
+        numerator += C * UNR[i * (Dim + 1) + Dim];
+        denominator += C;
+    }
+    return numerator / std::max(denominator, 1e-10);
+}
+
+// replay inputs through the O(r) membership (closed form for m == 2, per-rule powers otherwise)
+// and through the pairwise reference, the results must agree within 1e-12
+static bool checkMembershipPaths(const std::vector<std::array<double, inputDim>>& inputs) {
+    bool pass = true;
+    for (double m : {2.0, 1.5, 2.5, 3.0}) {
+        GT2FCM fuzzyModel(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numRules, inputDim, numMF, m);
+        GT2FCM_Fixed<numRules, inputDim> fuzzyModelFixed(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numMF, m);
+
+        // add samples sitting exactly on the rule centers, they hit the 1e-10 distance clamp
+        auto samples = inputs;
+        const auto& UNR = fuzzyModelFixed.getUNR();
+        for (int i = 0; i < numRules; i++) {
+            std::array<double, inputDim> x;
+            for (int n = 0; n < inputDim; n++)
+                x[n] = UNR[i * (inputDim + 1) + n];
+            samples.push_back(x);
+        }
+
+        std::vector<double> outBatch(samples.size());
+        fuzzyModel.calculateBatch(samples[0].data(), samples.size(), outBatch.data());
+
+        double maxErr = 0;
+        std::vector<double> inputData(inputDim);
+        for (size_t k = 0; k < samples.size(); k++) {
+            const auto& x = samples[k];
+            double ref = calculatePairwise(fuzzyModelFixed, x.data());
+            inputData.assign(x.begin(), x.end());
+            maxErr = std::max(maxErr, std::abs(fuzzyModel.calculate(inputData) - ref));
+            maxErr = std::max(maxErr, std::abs(fuzzyModelFixed.calculate(x) - ref));
+            maxErr = std::max(maxErr, std::abs(outBatch[k] - ref));
+        }
+        bool ok = maxErr <= 1e-12;
+        pass = pass && ok;
+        printf("[membership] m = %.1f, samples: %zu, max |diff| vs pairwise: %.3e %s\n",
+               m, samples.size(), maxErr, ok ? "PASS" : "FAIL");
+    }
+    return pass;
+}
+
+int main(int argc, const char **argv) {
+    const size_t sampleNum = 200000;
+    auto inputs = makeInputs(sampleNum);
+
+    auto replayInputs = (argc > 1) ? loadInputs(argv[1]) : makeInputs(10000);
+    bool pass = checkMembershipPaths(replayInputs);
+    pass = speedTestStableContact(20000) && pass;
+    pass = speedTestMedianFilter(300000) && pass;
+    pass = checkNormalization(200000) && pass;
+
+    speedTestGT2FCM(inputs);
+    speedTestBatch(inputs);
+    speedTestEstimator(2, 20000);
+    speedTestEstimator(4, 20000);
+    speedTestCompiled(20000);
+
+    if (!pass)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "Contact_Sweep.h"
+#include "Contact_Estimator.h"
+
+// Sweep of the contact detection parameters over recorded DataLogger logs, no simulation needed.
+// The logs are loaded once, then every combination of low-pass cutoff, acceleration clipping,
+// beta_low/beta_high/pivot and decision threshold is scored against touch >= 5 N on all cores.
+// Results are ranked by F1, ties by touchdown and liftoff delay.
+// usage: ./contact_sweep [-j threads] [--top N] [--model gt2fcm.json] [--script matlabReadDataScript.txt]
+//                        [datalog.log ...]
+// without logs ../record/datalog.log is used.
+
+static void printResult(size_t rank, const ContactSweepResult& r) {
+    printf("%5zu  F1 %.4f  P %.4f R %.4f  td %6.1f ms lo %6.1f ms miss %3zu | fc %5.1f acc %5.1f  bl %5.1f bh %5.1f"
+           "  pivot %.3f thr %.3f (raw > %.4f)\n",
+           rank, r.f1(), r.precision(), r.recall(), r.touchdownDelay, r.liftoffDelay, r.missedTouchdowns,
+           r.cutoffFreq, r.accThreshold, r.betaLow, r.betaHigh, r.pivot, r.threshold, r.rawThreshold);
+}
+
+int main(int argc, const char **argv) {
+    unsigned threads = 0;
+    size_t top = 20;
+    std::string script, model;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--top") && i + 1 < argc)
+            top = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc)
+            model = argv[++i];
+        else if (!strcmp(argv[i], "--script") && i + 1 < argc)
+            script = argv[++i];
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty())
+        files.push_back("../record/datalog.log");
+
+    ContactSweep sweep;
+    ContactEstimator reference(2, 100);
+    try {
+        if (!model.empty()) {
+            sweep.loadModel(model.c_str());
+            reference.loadModel(model.c_str());
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& file : files)
+            sweep.addLog(file, script, reference.hipJointIdx, reference.kneeJointIdx);
+        printf("[sweep] loaded %zu logs, %zu sequences, %zu frames in %.2f s\n", files.size(), sweep.sequenceNum(),
+               sweep.frameNum(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } catch (const std::exception& e) {
+        std::cerr << "[sweep] " << e.what() << std::endl;
+        return 1;
+    }
+
+    ContactSweepGrid grid;
+    grid.cutoffFreq = {5, 8, 10, 12, 15, 20, 25, 30};
+    grid.accThreshold = {10, 15, 20, 25, 30, 40};
+    grid.betaLow = {6, 8, 10, 12, 14};
+    grid.betaHigh = {8, 10, 12, 14, 16};
+    grid.pivot = {0.55, 0.6, 0.65, 0.7, 0.75};
+    grid.threshold = {0.5, 0.6, 0.7, 0.75, 0.8, 0.9};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<ContactSweepResult> results = sweep.run(grid, threads);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("[sweep] %zu combinations in %.2f s: %zu filter runs, %zu distinct raw thresholds, %zu tasks stolen\n",
+           results.size(), seconds, sweep.filterRuns(), sweep.distinctThresholds(), sweep.stolenTasks());
+
+    // the shipped setting, checked against ContactEstimator::is_contact on the first log
+    ContactSweepGrid shipped;
+    ContactSweepResult ref = sweep.run(shipped, threads)[0];
+    printf("[sweep] shipped setting:\n");
+    printResult(0, ref);
+
+    ContactSweep first;
+    if (!model.empty())
+        first.loadModel(model.c_str());
+    const int feet = first.addLog(files[0], script, reference.hipJointIdx, reference.kneeJointIdx);
+    ContactSweepResult firstRes = first.run(shipped, threads)[0];
+    ContactEstimator estimator(feet, 100);
+    if (!model.empty())
+        estimator.loadModel(model.c_str());
+    size_t counts[4] = {0, 0, 0, 0};   // tp, fp, fn, tn
+    std::vector<ContactSensorFrame> frames(feet);
+    for (size_t k = 0; k < first.sequence(0).size(); k++) {
+        for (int f = 0; f < feet; f++)
+            frames[f] = first.sequence(f)[k];
+        estimator.step(frames);
+        for (int f = 0; f < feet; f++) {
+            const ContactEstimate& est = estimator.getEstimate(f);
+            counts[(est.contact_truth ? 0 : 1) + (est.is_contact ? 0 : 2)]++;
+        }
+    }
+    const bool same = counts[0] == firstRes.tp && counts[1] == firstRes.fp &&
+                      counts[2] == firstRes.fn && counts[3] == firstRes.tn;
+    printf("[sweep] %s: sweep tp %zu fp %zu fn %zu tn %zu, ContactEstimator tp %zu fp %zu fn %zu tn %zu  %s\n",
+           files[0].c_str(), firstRes.tp, firstRes.fp, firstRes.fn, firstRes.tn,
+           counts[0], counts[1], counts[2], counts[3], same ? "PASS" : "FAIL");
+
+    ContactSweep::rank(results);
+    printf("[sweep] top %zu by F1, then touchdown/liftoff delay:\n", std::min(top, results.size()));
+    for (size_t i = 0; i < std::min(top, results.size()); i++)
+        printResult(i + 1, results[i]);
+
+    return same ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "IT2FIS_Mamdani.h"
+#include "evaluateMyFIS.h"
+
+// Speed test of the native IT2 Mamdani engine against the MATLAB codegen evaluateMyFIS, no simulation needed.
+// 1. sampled reference of the engine with 101 samples must reproduce evaluateMyFIS, checks the config
+// 2. closed-form engine vs evaluateMyFIS, difference is the 101-point discretization of evaluateMyFIS
+// 3. closed-form engine vs the sampled reference on a fine grid, must converge
+// 4. latency of both
+// usage: ./fis_speed_test [stable_contact_fis.json] [recorded_inputs.txt]
+// the optional file holds one IT2FIS input (4 columns: probability, h_disp, h_vel, ang_vel) per line.
+
+static const int inputDim = 4;
+
+// keeps the timed results alive
+static volatile double benchmarkSink = 0;
+
+// best of several runs, in ns per call
+template<typename Func>
+static double timePerCall(size_t n, Func&& func, int repeat = 5) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t k = 0; k < n; k++)
+            func(k);
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / n);
+    }
+    return best;
+}
+
+// half uniform on [0, 1]^4, half shaped like the estimator output: probability near 0 or 1,
+// small displacement and velocities
+static std::vector<std::array<double, inputDim>> makeInputs(size_t n) {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    std::exponential_distribution<double> small(8.0);
+    std::vector<std::array<double, inputDim>> inputs(n);
+    for (size_t k = 0; k < n; k++) {
+        auto& x = inputs[k];
+        if (k % 2 == 0) {
+            for (auto& v : x)
+                v = uni(gen);
+        } else {
+            double p = uni(gen);
+            x[0] = p < 0.4 ? 0.05 * uni(gen) : (p < 0.8 ? 1.0 - 0.05 * uni(gen) : uni(gen));
+            for (int i = 1; i < inputDim; i++)
+                x[i] = std::min(small(gen), 1.0);
+        }
+    }
+    return inputs;
+}
+
+static std::vector<std::array<double, inputDim>> loadInputs(const char* fileName) {
+    std::vector<std::array<double, inputDim>> inputs;
+    std::ifstream file(fileName);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::array<double, inputDim> x;
+        int k = 0;
+        while (k < inputDim && (ss >> x[k]))
+            k++;
+        if (k == inputDim)
+            inputs.push_back(x);
+    }
+    return inputs;
+}
+
+static bool checkAgreement(IT2MamdaniFIS& fis, const std::vector<std::array<double, inputDim>>& inputs) {
+    size_t sampledMismatch = 0, decisionMismatch = 0;
+    double maxErr = 0, sumErr = 0, maxFineErr = 0;
+    for (size_t k = 0; k < inputs.size(); k++) {
+        const double* x = inputs[k].data();
+        double ref = evaluateMyFIS(x);
+        double sampled = fis.evaluateSampled(x, 101);
+        double native = fis.evaluate(x);
+        sampledMismatch += std::abs(sampled - ref) > 1e-12;
+        double err = std::abs(native - ref);
+        maxErr = std::max(maxErr, err);
+        sumErr += err;
+        decisionMismatch += (native > 0.5) != (ref > 0.5);
+        if (k % 10 == 0)
+            maxFineErr = std::max(maxFineErr, std::abs(native - fis.evaluateSampled(x, 100001)));
+    }
+    const double tol = 0.02;
+    bool ok = sampledMismatch == 0 && maxErr <= tol && maxFineErr <= 1e-4;
+    printf("[IT2FIS] %zu inputs: sampled(101) vs evaluateMyFIS mismatches %zu\n", inputs.size(), sampledMismatch);
+    printf("  closed form vs evaluateMyFIS: max |diff| %.2e, mean %.2e (tolerance %.2f), decision at 0.5 differs %zu times\n",
+           maxErr, sumErr / inputs.size(), tol, decisionMismatch);
+    printf("  closed form vs sampled(100001): max |diff| %.2e  %s\n", maxFineErr, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+static void speedTest(IT2MamdaniFIS& fis, const std::vector<std::array<double, inputDim>>& inputs) {
+    double sink = 0;
+    const size_t n = inputs.size();
+    double tRef = timePerCall(n, [&](size_t k) { sink += evaluateMyFIS(inputs[k].data()); });
+    double tNative = timePerCall(n, [&](size_t k) { sink += fis.evaluate(inputs[k].data()); });
+    benchmarkSink = sink;
+    printf("[IT2FIS] evaluateMyFIS %8.1f ns/call, IT2MamdaniFIS %8.1f ns/call, speedup x%.1f\n",
+           tRef, tNative, tRef / tNative);
+}
+
+int main(int argc, const char **argv) {
+    const char* configPath = argc > 1 ? argv[1] : "../common/stable_contact_fis.json";
+    IT2MamdaniFIS fis(configPath);
+    printf("[IT2FIS] %s: %d inputs, %d rules\n", configPath, fis.inputNum(), fis.ruleNum());
+
+    auto inputs = (argc > 2) ? loadInputs(argv[2]) : makeInputs(20000);
+    bool pass = checkAgreement(fis, inputs);
+    speedTest(fis, makeInputs(200000));
+
+    if (!pass)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "GT2FIS_Contact.h"
+#include "GT2FIS_Contact_Fixed.h"
+#include "GT2FIS_Default_Model.h"
+#include "GT2FIS_Model_File.h"
+#include "Contact_Estimator.h"
+
+// Writes the shipped GT2FCM left foot model as binary + JSON sidecar and checks the round trip:
+// outputs of GT2FCM, GT2FCM_Fixed and ContactEstimator loaded from the file must be identical
+// to the compiled-in model.
+// usage: ./gt2fcm_model_export [gt2fcm_left_foot.json]
+
+static const int numRules = 13;
+static const int inputDim = 5;
+static const int numMF = 7;
+
+int main(int argc, const char **argv) {
+    const char* jsonPath = argc > 1 ? argv[1] : "../common/gt2fcm_left_foot.json";
+
+    GT2FCM_Fixed<numRules, inputDim> reference(GT2FCM_DefaultRuleBase(), GT2FCM_DefaultUncertaintyWeights(), numMF);
+    // DataFilterNormalizer::initialize() divides by 1, the recorded maxima were never applied
+    const std::array<double, inputDim> normalization = DataFilterNormalizer().getNormalization();
+    GT2FCM_ModelFile::save(jsonPath, "AzureLoong left foot contact",
+                           "GT2FCM contact model, UNR reduced from 7 MFs x 13 rules, inputs normalized by DataFilterNormalizer",
+                           reference.getUNR().data(), normalization.data(), numRules, inputDim, numMF,
+                           reference.getFcmConstant(),
+                           {"acc_vertical", "vel_vertical", "hip_joint_pos", "knee_joint_pos", "acc_vertical_diff"});
+
+    auto start = std::chrono::high_resolution_clock::now();
+    GT2FCM_ModelFile model(jsonPath);
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("[model] %s: %s, %d rules, %d inputs, load %.1f us\n", jsonPath, model.name().c_str(),
+           model.numRules(), model.inputDim(), std::chrono::duration<double, std::micro>(end - start).count());
+
+    GT2FCM dynamicModel;
+    dynamicModel.loadModel(jsonPath);
+    GT2FCM_Fixed<numRules, inputDim> fixedModel;
+    fixedModel.setUNR(model.unr(), model.fcmConstant());
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> x(inputDim);
+    size_t mismatch = 0;
+    for (int k = 0; k < 100000; k++) {
+        for (auto& v : x)
+            v = dist(gen);
+        double ref = reference.calculate(x);
+        mismatch += dynamicModel.calculate(x) != ref;
+        mismatch += fixedModel.calculate(x) != ref;
+    }
+
+    // estimator pipeline with the compiled-in and the loaded model
+    ContactEstimator builtin(1, 100), loaded(1, 100);
+    loaded.loadModel(jsonPath);
+    ContactSensorFrame frame;
+    for (int k = 0; k < 20000; k++) {
+        const double t = k * 0.001;
+        frame.acc = {0.3 * std::sin(7 * t), 0.2 * std::cos(5 * t), 9.81 + 4 * std::sin(11 * t)};
+        frame.rpy = {0.05 * std::sin(t), 0.05 * std::cos(t), 0};
+        frame.linear_vel = {0.2 * std::sin(3 * t), 0, 0.5 * std::cos(6 * t)};
+        frame.angular_vel = {0.1 * std::sin(2 * t), 0.1, 0};
+        frame.pos = {0.01 * t, 0.1, 0.05 * (1 + std::sin(6 * t))};
+        frame.hip_joint_pos = 0.3 * std::sin(6 * t);
+        frame.knee_joint_pos = 0.6 + 0.4 * std::sin(6 * t);
+        builtin.step(&frame);
+        loaded.step(&frame);
+        mismatch += builtin.getEstimate(0).probability != loaded.getEstimate(0).probability;
+    }
+
+    printf("[model] round trip mismatches: %zu %s\n", mismatch, mismatch == 0 ? "PASS" : "FAIL");
+    return mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "GT2FCM_Trainer.h"
+#include "Contact_Log.h"
+#include "Contact_Sweep.h"
+#include "Contact_Estimator.h"
+
+// Trains the GT2FCM contact rule base from recorded DataLogger logs and writes a model file for
+// ContactEstimator::loadModel. Before that a self-check fits blobs with known centres.
+// The trained and the shipped model are then scored on the same logs, with the shipped squashing/threshold
+// and with the best pivot/threshold of each model.
+// usage: ./gt2fcm_train [-j threads] [-o gt2fcm_trained.json] [--rules 13] [--mf 7] [--epochs 10]
+//                       [--batch 65536] [--script matlabReadDataScript.txt] [datalog.log ...]
+// without logs ../record/datalog.log is used.
+
+// three blobs in 2D with labels 1, 0, 1, the centres have to come back within 0.05
+static bool selfCheck(unsigned threads) {
+    const double truth[3][3] = {{-0.6, -0.5, 1.0}, {0.1, 0.6, 0.0}, {0.7, -0.3, 1.0}};
+    GT2FCM_Trainer trainer(2);
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 0.08);
+    for (int s = 0; s < 300000; s++) {
+        const double* c = truth[s % 3];
+        const double x[2] = {c[0] + noise(rng), c[1] + noise(rng)};
+        trainer.addSample(x, c[2]);
+    }
+    GT2FCM_TrainerOptions opt;
+    opt.numRules = 3;
+    opt.numMF = 3;
+    opt.batchSize = 8192;
+    opt.threads = threads;
+    auto start = std::chrono::steady_clock::now();
+    trainer.train(opt);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const std::vector<double> unr = trainer.unr();
+    double worst = 0.0;
+    for (const auto& c : truth) {
+        double best = 1e9;
+        for (int i = 0; i < 3; i++) {
+            const double dx = unr[i * 3] - c[0], dy = unr[i * 3 + 1] - c[1], dy2 = unr[i * 3 + 2] - c[2];
+            best = std::min(best, std::sqrt(dx * dx + dy * dy + dy2 * dy2));
+        }
+        worst = std::max(worst, best);
+    }
+    const bool ok = worst < 0.05;
+    printf("[train] self-check: 3 blobs, %zu samples, %.2f s, worst centre error %.4f  %s\n",
+           trainer.sampleNum(), seconds, worst, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+int main(int argc, const char **argv) {
+    unsigned threads = 0;
+    std::string script, output = "gt2fcm_trained.json";
+    GT2FCM_TrainerOptions opt;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            output = argv[++i];
+        else if (!strcmp(argv[i], "--rules") && i + 1 < argc)
+            opt.numRules = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--mf") && i + 1 < argc)
+            opt.numMF = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--epochs") && i + 1 < argc)
+            opt.epochs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--batch") && i + 1 < argc)
+            opt.batchSize = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--script") && i + 1 < argc)
+            script = argv[++i];
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty())
+        files.push_back("../record/datalog.log");
+    opt.threads = threads;
+
+    if (!selfCheck(threads))
+        return 1;
+
+    ContactEstimator reference(2, 100);
+    GT2FCM_Trainer trainer;
+    ContactSweep shipped, trained;
+    try {
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& file : files) {
+            ContactLog log = readContactLog(file, script, reference.hipJointIdx, reference.kneeJointIdx);
+            for (auto& frames : log.feet) {
+                trainer.addSequence(frames);
+                shipped.addSequence(frames, log.dt);
+                trained.addSequence(std::move(frames), log.dt);
+            }
+        }
+        printf("[train] %zu logs, %zu samples in %.2f s\n", files.size(), trainer.sampleNum(),
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        start = std::chrono::steady_clock::now();
+        trainer.train(opt);
+        printf("[train] %d rules x %d MFs in %.2f s: %zu batch updates, objective %.4g, %zu tasks stolen\n",
+               opt.numRules, opt.numMF, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+               trainer.batchUpdates(), trainer.objective(), trainer.stolenTasks());
+        trainer.save(output.c_str(), "Trained contact model",
+                     "GT2FCM contact model fitted by GT2FCM_Trainer, inputs normalized by DataFilterNormalizer");
+        printf("[train] wrote %s\n", output.c_str());
+        if (opt.numRules == ContactEstimator::numRules) {
+            trained.loadModel(output.c_str());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[train] " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (opt.numRules != ContactEstimator::numRules) {
+        printf("[train] %d rules, ContactEstimator needs %d, not scored\n", opt.numRules, ContactEstimator::numRules);
+        return 0;
+    }
+    // shipped squashing and threshold, then the best pivot/threshold of each model since the output ranges differ
+    ContactSweepGrid grid;
+    ContactSweepGrid thresholds;
+    thresholds.pivot.clear();
+    for (double p = 0.1; p < 0.95; p += 0.05)
+        thresholds.pivot.push_back(p);
+    thresholds.threshold = {0.5, 0.75, 0.9};
+    for (ContactSweep* sweep : {&shipped, &trained}) {
+        const ContactSweepResult at = sweep->run(grid, threads)[0];
+        std::vector<ContactSweepResult> all = sweep->run(thresholds, threads);
+        ContactSweep::rank(all);
+        const ContactSweepResult& best = all[0];
+        printf("[train] %s model: F1 %.4f  P %.4f R %.4f  td %.1f ms lo %.1f ms | best pivot %.2f thr %.2f: F1 %.4f "
+               "td %.1f ms lo %.1f ms\n", sweep == &shipped ? "shipped" : "trained",
+               at.f1(), at.precision(), at.recall(), at.touchdownDelay, at.liftoffDelay,
+               best.pivot, best.threshold, best.f1(), best.touchdownDelay, best.liftoffDelay);
+    }
+    return 0;
+}
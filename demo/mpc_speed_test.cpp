@@ -0,0 +1,199 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "mpc.h"
+#include "useful_math.h"
+#include "data_bus.h"
+
+// Speed test of MPC::cal, no simulation needed. A walking state is fed through dataBusRead and set_weight as in
+// walk_mpc_wbc, then the prediction matrices and the QP cost are built by
+// 1. the previous cal(): Aqp, Aqp1 (120x120) and Bqp1 rebuilt with nested loops of 12x12 products,
+//    Bqp = Aqp1*(Bqp1*Bqp11) and H, c with the dense 120x120 L
+// 2. MPC::updatePrediction: one recursion over the horizon skipping the zero blocks of A and Bqp, H and c summed
+//    over the diagonal blocks of L
+// Aqp, Bqp, H and c of both must agree. The time of cal() with the previous build is cal() - (2) + (1).
+
+// keeps the timed results alive
+static volatile double benchmarkSink = 0;
+
+// model constants of mpc.cpp
+const double mpcMass = 77.35;
+
+struct ReferenceOutput {
+    Eigen::MatrixXd Aqp, Bqp, H, c;
+};
+
+// previous cal() up to H and c
+static ReferenceOutput referencePrediction(double dt, double yaw, const Eigen::Matrix<double, 6, 1> &pf2com,
+                                           const Eigen::MatrixXd &L, const Eigen::MatrixXd &K, double alpha,
+                                           const Eigen::VectorXd &X_cur, const Eigen::VectorXd &Xd,
+                                           const Eigen::VectorXd &delta_U) {
+    const double m = mpcMass;
+    Eigen::Matrix3d Ic;
+    Ic << 12.61, 0, 0.37, 0, 11.15, 0.01, 0.37, 0.01, 2.15;
+    Eigen::Matrix<double, nx, nx> Ac[mpc_N], A[mpc_N];
+    Eigen::Matrix<double, nx, nu> Bc[mpc_N], B[mpc_N];
+    Eigen::Matrix3d R_curz[mpc_N];
+    for (int i = 0; i < mpc_N; i++) {
+        R_curz[i] = Rz3(yaw);
+        Ac[i].setZero();
+        Bc[i].setZero();
+    }
+    for (int i = 0; i < mpc_N; i++) {
+        Ac[i].block<3, 3>(0, 6) = R_curz[i].transpose();
+        Ac[i].block<3, 3>(3, 9) = Eigen::MatrixXd::Identity(3, 3);
+        A[i] = Eigen::MatrixXd::Identity(nx, nx) + dt * Ac[i];
+    }
+    for (int i = 0; i < mpc_N; i++) {
+        Eigen::Matrix3d Ic_W_inv = (R_curz[i] * Ic * R_curz[i].transpose()).inverse();
+        Bc[i].block<3, 3>(6, 0) = Ic_W_inv * CrossProduct_A(pf2com.block<3, 1>(0, 0));
+        Bc[i].block<3, 3>(6, 3) = Ic_W_inv;
+        Bc[i].block<3, 3>(6, 6) = Ic_W_inv * CrossProduct_A(pf2com.block<3, 1>(3, 0));
+        Bc[i].block<3, 3>(6, 9) = Ic_W_inv;
+        Bc[i].block<3, 3>(9, 0) = Eigen::MatrixXd::Identity(3, 3) / m;
+        Bc[i].block<3, 3>(9, 6) = Eigen::MatrixXd::Identity(3, 3) / m;
+        Bc[i]((nx - 1), (nu - 1)) = 1.0 / m;
+        B[i] = dt * Bc[i];
+    }
+    Eigen::MatrixXd Aqp = Eigen::MatrixXd::Zero(nx * mpc_N, nx);
+    Eigen::MatrixXd Aqp1 = Eigen::MatrixXd::Zero(nx * mpc_N, nx * mpc_N);
+    Eigen::MatrixXd Bqp1 = Eigen::MatrixXd::Zero(nx * mpc_N, nu * mpc_N);
+    for (int i = 0; i < mpc_N; i++)
+        Aqp.block<nx, nx>(i * nx, 0) = Eigen::MatrixXd::Identity(nx, nx);
+    for (int i = 0; i < mpc_N; i++)
+        for (int j = 0; j < i + 1; j++)
+            Aqp.block<nx, nx>(i * nx, 0) = A[j] * Aqp.block<nx, nx>(i * nx, 0);
+    for (int i = 0; i < mpc_N; i++)
+        for (int j = 0; j < i + 1; j++)
+            Aqp1.block<nx, nx>(i * nx, j * nx) = Eigen::MatrixXd::Identity(nx, nx);
+    for (int i = 1; i < mpc_N; i++)
+        for (int j = 0; j < i; j++)
+            for (int k = j + 1; k < (i + 1); k++)
+                Aqp1.block<nx, nx>(i * nx, j * nx) = A[k] * Aqp1.block<nx, nx>(i * nx, j * nx);
+    for (int i = 0; i < mpc_N; i++)
+        Bqp1.block<nx, nu>(i * nx, i * nu) = B[i];
+    Eigen::MatrixXd Bqp11 = Eigen::MatrixXd::Zero(nu * mpc_N, nu * ch);
+    Bqp11.block<nu * ch, nu * ch>(0, 0) = Eigen::MatrixXd::Identity(nu * ch, nu * ch);
+    for (int i = 0; i < (mpc_N - ch); i++)
+        Bqp11.block<nu, nu>(nu * ch + i * nu, nu * (ch - 1)) = Eigen::MatrixXd::Identity(nu, nu);
+    Eigen::MatrixXd B_tmp = Bqp1 * Bqp11;
+    ReferenceOutput out;
+    out.Aqp = Aqp;
+    out.Bqp = Aqp1 * B_tmp;
+    out.H = 2 * (out.Bqp.transpose() * L * out.Bqp + alpha * K) +
+            1e-10 * Eigen::MatrixXd::Identity(nu * ch, nu * ch);
+    out.c = 2 * out.Bqp.transpose() * L * (Aqp * X_cur - Xd) + 2 * alpha * K * delta_U;
+    return out;
+}
+
+// weights of set_weight: diagonal, the 3x3 blocks rotated by the yaw
+static void referenceWeights(double yaw, const Eigen::Matrix<double, 1, nx> &L_diag,
+                             const Eigen::Matrix<double, 1, nu> &K_diag, Eigen::MatrixXd &L, Eigen::MatrixXd &K) {
+    const Eigen::Matrix3d R = Rz3(yaw);
+    L = Eigen::MatrixXd::Zero(nx * mpc_N, nx * mpc_N);
+    K = Eigen::MatrixXd::Zero(nu * ch, nu * ch);
+    for (int i = 0; i < mpc_N; i++)
+        for (int j = 0; j < nx; j++)
+            L(i * nx + j, i * nx + j) = L_diag(j);
+    for (int i = 0; i < ch; i++)
+        for (int j = 0; j < nu; j++)
+            K(i * nu + j, i * nu + j) = K_diag(j);
+    for (int i = 0; i < mpc_N; i++)
+        for (int b = 3; b < nx; b += 3)
+            L.block<3, 3>(i * nx + b, i * nx + b) = R * L.block<3, 3>(i * nx + b, i * nx + b) * R.transpose();
+    for (int i = 0; i < ch; i++)
+        for (int b = 0; b < 12; b += 3)
+            K.block<3, 3>(i * nu + b, i * nu + b) = R * K.block<3, 3>(i * nu + b, i * nu + b) * R.transpose();
+}
+
+template<typename Func>
+static double timePerCall(size_t n, Func &&func, int repeat = 5) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t k = 0; k < n; k++)
+            func();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count() / n);
+    }
+    return best;
+}
+
+int main() {
+    const double dt = 0.005;    // MPC period of walk_mpc_wbc
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+
+    DataBus data(37);
+    data.base_rpy << 0.02, -0.01, 0.4;
+    data.q.block<3, 1>(0, 0) << 0.1, 0.05, 1.05;
+    for (int i = 0; i < 6; i++)
+        data.dq(i) = 0.2 * u(gen);
+    data.fe_l_pos_W << 0.12, 0.16, 0.02;
+    data.fe_r_pos_W << 0.05, -0.08, 0.0;
+    data.fe_l_rot_W = Rz3(0.4);
+    data.fe_r_rot_W = Rz3(0.4);
+    data.slop.setZero();
+    data.js_eul_des << 0.0, 0.0, 0.42;
+    data.js_pos_des << 0.11, 0.05, 1.05;
+    data.js_omega_des << 0.0, 0.0, 0.1;
+    data.js_vel_des << 0.3, 0.0, 0.0;
+    data.phi = 0.3;
+    data.legState = DataBus::DSt;
+    data.legStateNext = DataBus::LSt;
+
+    Eigen::Matrix<double, 1, nx> L_diag;
+    Eigen::Matrix<double, 1, nu> K_diag;
+    L_diag << 1.0, 1.0, 1.0, 1.0, 200.0, 1.0, 1e-7, 1e-7, 1e-7, 100.0, 10.0, 1.0;
+    K_diag.setOnes();
+    const double alpha = 1e-6;
+
+    MPC mpc(dt);
+    mpc.enable();
+    mpc.dataBusRead(data);
+    mpc.set_weight(alpha, L_diag, K_diag);
+    mpc.dataBusWrite(data);     // Xd and X_cur for the reference
+    mpc.updatePrediction();
+
+    const double yaw = data.base_rpy(2);
+    Eigen::Matrix<double, 6, 1> pf2com;
+    pf2com.block<3, 1>(0, 0) = data.fe_l_pos_W - data.q.block<3, 1>(0, 0);
+    pf2com.block<3, 1>(3, 0) = data.fe_r_pos_W - data.q.block<3, 1>(0, 0);
+    Eigen::MatrixXd L, K;
+    referenceWeights(yaw, L_diag, K_diag, L, K);
+    Eigen::VectorXd delta_U = Eigen::VectorXd::Zero(nu * ch);
+    for (int i = 0; i < ch; i++) {
+        delta_U(nu * i + 2) = 0.5 * mpcMass * -9.8;
+        delta_U(nu * i + 8) = 0.5 * mpcMass * -9.8;
+    }
+    const Eigen::VectorXd X_cur = data.X_cur, Xd = data.Xd;
+    const ReferenceOutput ref = referencePrediction(dt, yaw, pf2com, L, K, alpha, X_cur, Xd, delta_U);
+
+    auto relErr = [](const Eigen::MatrixXd &a, const Eigen::MatrixXd &b) {
+        return (a - b).norm() / std::max(1e-12, b.norm());
+    };
+    const double err = std::max({relErr(mpc.get_Aqp(), ref.Aqp), relErr(mpc.get_Bqp(), ref.Bqp),
+                                 relErr(mpc.get_H(), ref.H), relErr(mpc.get_c(), ref.c)});
+
+    const size_t n = 2000;
+    const double tRef = timePerCall(n, [&]() {
+        ReferenceOutput r = referencePrediction(dt, yaw, pf2com, L, K, alpha, X_cur, Xd, delta_U);
+        benchmarkSink = benchmarkSink + r.c(0);
+    });
+    const double tNew = timePerCall(n, [&]() {
+        mpc.updatePrediction();
+        benchmarkSink = benchmarkSink + mpc.get_c()(0);
+    });
+    const double tCal = timePerCall(n / 10, [&]() { mpc.cal(); });
+
+    const bool ok = err < 1e-9;
+    printf("[mpc] prediction + cost: previous %.1f us, recursion %.1f us (x%.2f), max rel. diff %.2e %s\n",
+           tRef, tNew, tRef / tNew, err, ok ? "PASS" : "FAIL");
+    const double tCalPrev = tCal - tNew + tRef;
+    printf("[mpc] cal(): previous %.1f us, now %.1f us (x%.2f)\n", tCalPrev, tCal, tCalPrev / tCal);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "priority_tasks.h"
+#include "useful_math.h"
+
+// Speed test of the WBC kinematic layer (PriorityTasks::computeAll), no simulation needed.
+// The walk and stand task lists of WBC_priority with their task sizes (nv = 37) and random Jacobians, solved by
+// 1. the previous computeAll: three weighted pseudo inverses and one dynamic pseudo inverse per task, each a fresh
+//    complete orthogonal decomposition, dense nv x nv null-space projectors N
+// 2. PriorityTasks::computeAll: one factorization of each kind per task, pseudo inverses and N applied implicitly
+// The outputs of both must agree.
+// A second run scales the task count from 4 to 16 with limb-local Jacobians (legs, arms, head gaze, waist posture)
+// and compares the sparsity-aware cascade, which works on the active columns of every task, with the dense one.
+
+// keeps the timed results alive
+static volatile double benchmarkSink = 0;
+
+const int nv = 37;
+
+// column groups of dq: floating base, arm-l, arm-r, head, waist, leg-l, leg-r
+enum ColGroup : unsigned {
+    Base = 1, ArmL = 2, ArmR = 4, Head = 8, Waist = 16, LegL = 32, LegR = 64, AllCols = 127
+};
+static const int groupStart[7] = {0, 6, 13, 20, 22, 25, 31};
+static const int groupSize[7] = {6, 7, 7, 2, 3, 6, 6};
+
+struct TaskSpec {
+    const char *name;
+    int rows;
+    int selectFrom;     // -1: dense Jacobian, otherwise joint selection starting at this column
+    unsigned groups = AllCols;  // columns of a dense Jacobian that are nonzero
+};
+
+// previous implementation, kept as the reference
+struct ReferenceOutput {
+    Eigen::VectorXd delta_q, dq, ddq;
+};
+
+static ReferenceOutput referenceComputeAll(PriorityTasks &tasks, const Eigen::VectorXd &des_delta_q,
+                                           const Eigen::VectorXd &des_dq, const Eigen::VectorXd &des_ddq,
+                                           const Eigen::MatrixXd &dyn_M_inv, const Eigen::VectorXd &dq) {
+    std::vector<Eigen::MatrixXd> N(tasks.taskLib.size()), Jpre(tasks.taskLib.size());
+    std::vector<Eigen::VectorXd> delta_q(tasks.taskLib.size()), dqRes(tasks.taskLib.size()), ddq(tasks.taskLib.size());
+    int curId = tasks.startId;
+    int parentId = tasks.taskLib[curId].parentId;
+    int childId = tasks.taskLib[curId].childId;
+    for (size_t i = 0; i < tasks.taskLib.size(); i++) {
+        const Task &t = tasks.taskLib[curId];
+        Eigen::VectorXd ddxcmd = t.ddxDes + t.kp * t.errX + t.kd * t.derrX;
+        if (parentId == -1) {
+            N[curId] = Eigen::MatrixXd::Identity(t.J.cols(), t.J.cols());
+            Jpre[curId] = t.J * N[curId];
+            delta_q[curId] = des_delta_q + pseudoInv_right_weighted(Jpre[curId], t.W) * t.errX;
+            dqRes[curId] = des_dq;
+            ddq[curId] = des_ddq + dyn_pseudoInv(Jpre[curId], dyn_M_inv, true) * (ddxcmd - t.dJ * dq);
+        } else {
+            const Task &p = tasks.taskLib[parentId];
+            N[curId] = N[parentId] * (Eigen::MatrixXd::Identity(Jpre[parentId].cols(), Jpre[parentId].cols()) -
+                                      pseudoInv_right_weighted(Jpre[parentId], p.W) * Jpre[parentId]);
+            Jpre[curId] = t.J * N[curId];
+            delta_q[curId] = delta_q[parentId] +
+                             pseudoInv_right_weighted(Jpre[curId], t.W) * (t.errX - t.J * delta_q[parentId]);
+            dqRes[curId] = dqRes[parentId] +
+                           pseudoInv_right_weighted(Jpre[curId], t.W) * (t.dxDes - t.J * dqRes[parentId]);
+            ddq[curId] = ddq[parentId] + dyn_pseudoInv(Jpre[curId], dyn_M_inv, true) *
+                                         (ddxcmd - t.dJ * dq - t.J * ddq[parentId]);
+        }
+        if (childId != -1) {
+            parentId = curId;
+            curId = childId;
+            childId = tasks.taskLib[curId].childId;
+        } else
+            break;
+    }
+    return {delta_q[curId], dqRes[curId], ddq[curId]};
+}
+
+static void buildTasks(PriorityTasks &tasks, const std::vector<TaskSpec> &specs, std::mt19937 &gen) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<std::string> order;
+    for (const TaskSpec &spec : specs) {
+        tasks.addTask(spec.name);
+        Task &t = tasks.taskLib.back();
+        const int m = spec.rows;
+        t.J = Eigen::MatrixXd::Zero(m, nv);
+        if (spec.selectFrom < 0) {
+            for (int g = 0; g < 7; g++)
+                if (spec.groups & (1u << g))
+                    for (int i = 0; i < m; i++)
+                        for (int j = groupStart[g]; j < groupStart[g] + groupSize[g]; j++)
+                            t.J(i, j) = u(gen);
+        } else {
+            for (int i = 0; i < m; i++)
+                t.J(i, spec.selectFrom + i) = 1;
+        }
+        t.dJ = Eigen::MatrixXd::Zero(m, nv);
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < nv; j++)
+                t.dJ(i, j) = 0.1 * u(gen);
+        t.errX = Eigen::VectorXd::NullaryExpr(m, [&]() { return 0.01 * u(gen); });
+        t.derrX = Eigen::VectorXd::NullaryExpr(m, [&]() { return 0.1 * u(gen); });
+        t.dxDes = Eigen::VectorXd::NullaryExpr(m, [&]() { return 0.1 * u(gen); });
+        t.ddxDes = Eigen::VectorXd::NullaryExpr(m, [&]() { return u(gen); });
+        t.kp = Eigen::MatrixXd::Identity(m, m) * 200;
+        t.kd = Eigen::MatrixXd::Identity(m, m) * 20;
+        t.W.diagonal() = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 1.0 + 0.5 * (u(gen) + 1.0); });
+        order.emplace_back(spec.name);
+    }
+    tasks.buildPriority(order);
+}
+
+template<typename Func>
+static double timePerCall(size_t n, Func &&func, int repeat = 5) {
+    double best = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t k = 0; k < n; k++)
+            func();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count() / n);
+    }
+    return best;
+}
+
+static bool runTaskList(const char *name, const std::vector<TaskSpec> &specs) {
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    PriorityTasks tasks;
+    buildTasks(tasks, specs, gen);
+
+    Eigen::MatrixXd A = Eigen::MatrixXd::NullaryExpr(nv, nv, [&]() { return u(gen); });
+    const Eigen::MatrixXd dyn_M = A * A.transpose() + nv * Eigen::MatrixXd::Identity(nv, nv);
+    const Eigen::MatrixXd dyn_M_inv = dyn_M.inverse();
+    const Eigen::VectorXd des_delta_q = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.001 * u(gen); });
+    const Eigen::VectorXd des_dq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.1 * u(gen); });
+    const Eigen::VectorXd des_ddq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return u(gen); });
+    const Eigen::VectorXd dq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.1 * u(gen); });
+
+    const ReferenceOutput ref = referenceComputeAll(tasks, des_delta_q, des_dq, des_ddq, dyn_M_inv, dq);
+    tasks.computeAll(des_delta_q, des_dq, des_ddq, dyn_M, dyn_M_inv, dq);
+    auto relErr = [](const Eigen::VectorXd &a, const Eigen::VectorXd &b) {
+        return (a - b).norm() / std::max(1e-12, b.norm());
+    };
+    const double err = std::max({relErr(tasks.out_delta_q, ref.delta_q), relErr(tasks.out_dq, ref.dq),
+                                 relErr(tasks.out_ddq, ref.ddq)});
+
+    const size_t n = 2000;
+    const double tRef = timePerCall(n, [&]() {
+        ReferenceOutput r = referenceComputeAll(tasks, des_delta_q, des_dq, des_ddq, dyn_M_inv, dq);
+        benchmarkSink = benchmarkSink + r.ddq(0);
+    });
+    const double tNew = timePerCall(n, [&]() {
+        tasks.computeAll(des_delta_q, des_dq, des_ddq, dyn_M, dyn_M_inv, dq);
+        benchmarkSink = benchmarkSink + tasks.out_ddq(0);
+    });
+
+    int rows = 0;
+    for (const TaskSpec &spec : specs)
+        rows += spec.rows;
+    const bool ok = err < 1e-8;
+    printf("[priority] %s: %zu tasks, %d rows, nv %d: previous %.1f us, factorize-once %.1f us (x%.2f), "
+           "max rel. diff %.2e %s\n", name, specs.size(), rows, nv, tRef, tNew, tRef / tNew, err, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// the first taskNum tasks of a limb-local task list, dense vs sparsity-aware cascade
+static bool runScaling(const std::vector<TaskSpec> &all) {
+    bool pass = true;
+    for (size_t taskNum = 4; taskNum <= all.size(); taskNum += 2) {
+        const std::vector<TaskSpec> specs(all.begin(), all.begin() + taskNum);
+        std::mt19937 gen(11);
+        std::uniform_real_distribution<double> u(-1.0, 1.0);
+        PriorityTasks tasks;
+        buildTasks(tasks, specs, gen);
+
+        Eigen::MatrixXd A = Eigen::MatrixXd::NullaryExpr(nv, nv, [&]() { return u(gen); });
+        const Eigen::MatrixXd dyn_M = A * A.transpose() + nv * Eigen::MatrixXd::Identity(nv, nv);
+        const Eigen::MatrixXd dyn_M_inv = dyn_M.inverse();
+        const Eigen::VectorXd des_delta_q = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.001 * u(gen); });
+        const Eigen::VectorXd des_dq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.1 * u(gen); });
+        const Eigen::VectorXd des_ddq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return u(gen); });
+        const Eigen::VectorXd dq = Eigen::VectorXd::NullaryExpr(nv, [&]() { return 0.1 * u(gen); });
+
+        const ReferenceOutput ref = referenceComputeAll(tasks, des_delta_q, des_dq, des_ddq, dyn_M_inv, dq);
+        tasks.exploitSparsity = false;
+        tasks.computeAll(des_delta_q, des_dq, des_ddq, dyn_M, dyn_M_inv, dq);
+        const ReferenceOutput dense = {tasks.out_delta_q, tasks.out_dq, tasks.out_ddq};
+        tasks.exploitSparsity = true;
+        tasks.computeAll(des_delta_q, des_dq, des_ddq, dyn_M, dyn_M_inv, dq);
+        auto relErr = [](const Eigen::VectorXd &a, const Eigen::VectorXd &b) {
+            return (a - b).norm() / std::max(1e-12, b.norm());
+        };
+        double err = 0;
+        for (const ReferenceOutput *o : {&ref, &dense})
+            err = std::max({err, relErr(tasks.out_delta_q, o->delta_q), relErr(tasks.out_dq, o->dq),
+                            relErr(tasks.out_ddq, o->ddq)});
+
+        const size_t n = 2000;
+        double t[2];
+        for (int sparse = 0; sparse < 2; sparse++) {
+            tasks.exploitSparsity = sparse == 1;
+            t[sparse] = timePerCall(n, [&]() {
+                tasks.computeAll(des_delta_q, des_dq, des_ddq, dyn_M, dyn_M_inv, dq);
+                benchmarkSink = benchmarkSink + tasks.out_ddq(0);
+            });
+        }
+
+        int rows = 0;
+        for (const TaskSpec &spec : specs)
+            rows += spec.rows;
+        const bool ok = err < 1e-8;
+        printf("[priority] scaling: %2zu tasks, %2d rows: dense %.1f us, sparse %.1f us (x%.2f), "
+               "max rel. diff %.2e %s\n", taskNum, rows, t[0], t[1], t[0] / t[1], err, ok ? "PASS" : "FAIL");
+        pass = ok && pass;
+    }
+    return pass;
+}
+
+int main() {
+    // task order and sizes of WBC_priority: kin_tasks_walk and kin_tasks_stand
+    const std::vector<TaskSpec> walk = {
+            {"RedundantJoints", 5, 20}, {"static_Contact", 3, -1}, {"PosRot", 6, -1}, {"SwingLeg", 6, -1},
+            {"HandTrackJoints", 14, 6}};
+    const std::vector<TaskSpec> stand = {
+            {"static_Contact", 12, -1}, {"CoMXY_HipRPY", 5, -1}, {"Pz", 1, -1}, {"HandTrackJoints", 14, 6},
+            {"HeadRP", 2, 20}};
+    bool pass = runTaskList("walk", walk);
+    pass = runTaskList("stand", stand) && pass;
+    // walk tasks restricted to the limbs they move, then head gaze, waist posture, hands, CoM and joint postures
+    const std::vector<TaskSpec> limbs = {
+            {"static_Contact", 3, -1, Base | LegL}, {"PosRot", 6, -1, Base}, {"SwingLeg", 6, -1, Base | LegR},
+            {"HeadGaze", 2, -1, Base | Waist | Head}, {"WaistPosture", 2, -1, Waist},
+            {"LeftHandPos", 3, -1, Base | Waist | ArmL}, {"RightHandPos", 3, -1, Base | Waist | ArmR},
+            {"LeftElbow", 1, -1, ArmL}, {"RightElbow", 1, -1, ArmR}, {"CoMXY", 2, -1, AllCols},
+            {"LeftWrist", 1, -1, ArmL}, {"RightWrist", 1, -1, ArmR}, {"HeadPosture", 1, -1, Head},
+            {"LeftArmPosture", 1, -1, ArmL}, {"RightArmPosture", 1, -1, ArmR}, {"LegPosture", 1, -1, LegL | LegR}};
+    pass = runScaling(limbs) && pass;
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <algorithm>
+#include <unistd.h>
+
+#include "shared_robot_data.h"
+#include "latency_stats.h"
+
+// Stress test of the shared memory ring used between walk_mpc_wbc and Contact_detection, no simulation needed.
+// Every reader maps the segment on its own, like a separate process would.
+// 1. burst: the producer publishes as fast as it can while readers copy the newest frame, no copy may be torn
+// 2. 1 kHz: readers block on the futex and read every frame, reports publish-to-read latency, drops and
+//    the histogram of the interval between frames at a reader (jitter)
+// usage: ./shm_ring_stress_test [readers]
+
+static const std::string shmName = "/openloong_ring_stress_test";
+
+// every field is derived from the sequence number, a torn copy mixes two frames
+static void fillFrame(SharedRobotData &f, uint64_t seq) {
+    double *fields = reinterpret_cast<double *>(&f);
+    const int num = offsetof(SharedRobotData, writeStampNs) / sizeof(double);
+    for (int i = 0; i < num; i++)
+        fields[i] = double(seq) + 0.001 * i;
+    f.writeStampNs = LatencyStats::nowNs();
+}
+
+static bool checkFrame(const SharedRobotData &f, uint64_t seq) {
+    const double *fields = reinterpret_cast<const double *>(&f);
+    const int num = offsetof(SharedRobotData, writeStampNs) / sizeof(double);
+    for (int i = 0; i < num; i++)
+        if (fields[i] != double(seq) + 0.001 * i)
+            return false;
+    return true;
+}
+
+struct ReaderResult {
+    uint64_t reads{0};
+    uint64_t torn{0};
+    uint64_t outOfOrder{0};
+    uint64_t dropped{0};
+    LatencyStats latency;
+    LatencyStats interval;  // between consecutive frames at the reader
+};
+
+static bool burstTest(int readerNum, uint64_t frameNum) {
+    RobotDataRing producer;
+    if (!producer.create(shmName))
+        return false;
+
+    std::atomic<bool> done{false};
+    std::vector<ReaderResult> results(readerNum);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerNum; r++) {
+        readers.emplace_back([&, r]() {
+            RobotDataRing ring;
+            if (!ring.open(shmName))
+                return;
+            ReaderResult &res = results[r];
+            SharedRobotData f;
+            uint64_t seq = 0, lastSeq = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (!ring.readLatest(f, seq))
+                    continue;
+                res.reads++;
+                if (!checkFrame(f, seq))
+                    res.torn++;
+                if (seq < lastSeq)
+                    res.outOfOrder++;
+                lastSeq = seq;
+            }
+        });
+    }
+
+    SharedRobotData f{};
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t seq = 1; seq <= frameNum; seq++) {
+        fillFrame(f, seq);
+        producer.publish(f);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    for (auto &t : readers)
+        t.join();
+
+    bool pass = true;
+    printf("[burst] frames: %lu, %.2f Mframes/s, readers: %d\n", (unsigned long) frameNum, frameNum / sec * 1e-6,
+           readerNum);
+    for (int r = 0; r < readerNum; r++) {
+        const ReaderResult &res = results[r];
+        bool ok = res.torn == 0 && res.outOfOrder == 0;
+        pass = pass && ok;
+        printf("  reader %d: reads %lu, torn %lu, out of order %lu %s\n", r, (unsigned long) res.reads,
+               (unsigned long) res.torn, (unsigned long) res.outOfOrder, ok ? "PASS" : "FAIL");
+    }
+    RobotDataRing::unlink(shmName);
+    return pass;
+}
+
+static bool pacedTest(int readerNum, uint64_t frameNum) {
+    RobotDataRing producer;
+    if (!producer.create(shmName))
+        return false;
+
+    std::atomic<bool> done{false};
+    std::atomic<int> ready{0};
+    std::vector<ReaderResult> results(readerNum);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < readerNum; r++) {
+        readers.emplace_back([&, r]() {
+            RobotDataRing ring;
+            if (!ring.open(shmName))
+                return;
+            ready++;
+            ReaderResult &res = results[r];
+            RobotDataRing::Cursor cursor;
+            SharedRobotData f;
+            uint64_t seq = 0, lastSeq = 0, lastNs = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                if (!ring.waitNewer(cursor.next - 1, 10000000))
+                    continue;
+                while (ring.readNext(cursor, f, seq)) {
+                    uint64_t nowNs = LatencyStats::nowNs();
+                    res.latency.add((nowNs - f.writeStampNs) * 1e-3);
+                    if (lastNs != 0)
+                        res.interval.add((nowNs - lastNs) * 1e-3);
+                    lastNs = nowNs;
+                    res.reads++;
+                    if (!checkFrame(f, seq))
+                        res.torn++;
+                    if (seq <= lastSeq)
+                        res.outOfOrder++;
+                    lastSeq = seq;
+                }
+            }
+            res.dropped = cursor.dropped;
+        });
+    }
+    while (ready.load() < readerNum)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    SharedRobotData f{};
+    auto next = std::chrono::steady_clock::now();
+    for (uint64_t seq = 1; seq <= frameNum; seq++) {
+        next += std::chrono::microseconds(1000);
+        std::this_thread::sleep_until(next);
+        fillFrame(f, seq);
+        producer.publish(f);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done = true;
+    for (auto &t : readers)
+        t.join();
+
+    bool pass = true;
+    printf("[1 kHz, futex wait] frames: %lu, readers: %d\n", (unsigned long) frameNum, readerNum);
+    for (int r = 0; r < readerNum; r++) {
+        const ReaderResult &res = results[r];
+        bool ok = res.torn == 0 && res.outOfOrder == 0 && res.reads + res.dropped == frameNum;
+        pass = pass && ok;
+        printf("  reader %d: reads %lu, dropped %lu, torn %lu %s\n", r, (unsigned long) res.reads,
+               (unsigned long) res.dropped, (unsigned long) res.torn, ok ? "PASS" : "FAIL");
+        res.latency.print("    publish to read latency");
+    }
+    results[0].interval.printHistogram("  reader 0 frame interval", 100, 20);
+    RobotDataRing::unlink(shmName);
+    return pass;
+}
+
+int main(int argc, const char **argv) {
+    int readerNum = (argc > 1) ? std::max(1, atoi(argv[1])) : 3;
+
+    bool pass = burstTest(readerNum, 5000000);
+    pass = pacedTest(readerNum, 3000) && pass;
+
+    if (!pass)
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,391 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#include <nlohmann/json.hpp>
+#include "telemetry_channel.h"
+#include "telemetry_publisher.h"
+#include "databus_telemetry.h"
+
+// Speed test of the Contact_Detection telemetry encoding, no websocket server needed.
+// 1. per-tick nlohmann::json objects + dump() of the four channels, as Contact_Detection published them before
+// 2. TelemetryChannel ros1 payloads of the same fields, every tick and with the Contact_Detection decimation
+// The payloads go to a sink instead of broadcastMessage. Heap allocations are counted with a global operator new.
+// The binary payload is decoded and compared field by field.
+// Subscription gating (Contact_Detection skips channels without subscribers) and a runtime decimation change
+// are checked as well.
+// 3. TelemetryPublisher: loop-side push() cost with a sink that keeps up and with a stalled sink, sample order and
+//    drop accounting (pushed == sent + dropped).
+// 4. the DataBus stream of walk_mpc_wbc: samples filled from a DataBus, sent by DataBusUdpSink to a loopback socket,
+//    every datagram parsed back and compared with the pushed sample.
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// keeps the encoded bytes alive
+static volatile size_t benchmarkSink = 0;
+
+struct TickData {
+    double t;
+    bool isContact, truth;
+    double probability;
+    std::array<double, 5> input;
+    std::array<double, 9> sensor;
+    std::array<double, 6> debug;
+};
+
+static std::vector<TickData> makeTicks(size_t n) {
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<TickData> ticks(n);
+    for (size_t k = 0; k < n; k++) {
+        TickData& d = ticks[k];
+        d.t = k * 0.001;
+        d.isContact = u(gen) > 0;
+        d.truth = u(gen) > 0;
+        d.probability = 0.5 + 0.5 * u(gen);
+        for (double& v : d.input) v = u(gen);
+        for (double& v : d.sensor) v = 10 * u(gen);
+        for (double& v : d.debug) v = u(gen);
+    }
+    return ticks;
+}
+
+static void publish(const uint8_t* data, size_t size) {
+    benchmarkSink = benchmarkSink + size + data[size - 1];
+}
+
+static size_t publishJson(const TickData& d) {
+    nlohmann::json sensorMsg = {
+        {"timestamp", d.t}, {"acc_x", d.sensor[0]}, {"acc_y", d.sensor[1]}, {"acc_z", d.sensor[2]},
+        {"rpy_x", d.sensor[3]}, {"rpy_y", d.sensor[4]}, {"rpy_z", d.sensor[5]}, {"vel_z", d.sensor[6]},
+        {"hip_joint_pos", d.sensor[7]}, {"knee_joint_pos", d.sensor[8]}};
+    nlohmann::json contactMsg = {
+        {"timestamp", d.t}, {"is_contact", d.isContact}, {"probability", d.probability}, {"contact_truth", d.truth}};
+    nlohmann::json inputMsg = {
+        {"timestamp", d.t}, {"lF_accz_normalized", d.input[0]}, {"lF_velz_normalized", d.input[1]},
+        {"hip_joint_normalized", d.input[2]}, {"knee_joint_normalized", d.input[3]},
+        {"lF_accz_diff_normalized", d.input[4]}};
+    nlohmann::json debugMsg = {
+        {"timestamp", d.t}, {"DebugData1", d.debug[0]}, {"DebugData2", d.debug[1]}, {"DebugData3", d.debug[2]},
+        {"DebugData4", d.debug[3]}, {"DebugData5", d.debug[4]}, {"DebugData6", d.debug[5]}};
+    size_t bytes = 0;
+    for (const nlohmann::json* msg : {&contactMsg, &sensorMsg, &inputMsg, &debugMsg}) {
+        std::string str = msg->dump();
+        publish(reinterpret_cast<const uint8_t*>(str.data()), str.size());
+        bytes += str.size();
+    }
+    return bytes;
+}
+
+struct Channels {
+    using Field = TelemetryChannel::Field;
+    static const TelemetryChannel::FieldType F64 = TelemetryChannel::FieldType::Float64;
+    static const TelemetryChannel::FieldType Bool = TelemetryChannel::FieldType::Bool;
+    TelemetryChannel contact{"contact_state", "ContactState", {
+        {"timestamp", F64}, {"is_contact", Bool}, {"probability", F64}, {"contact_truth", Bool}}};
+    TelemetryChannel input{"input_data", "InputData", {
+        {"timestamp", F64}, {"lF_accz_normalized", F64}, {"lF_velz_normalized", F64},
+        {"hip_joint_normalized", F64}, {"knee_joint_normalized", F64}, {"lF_accz_diff_normalized", F64}}};
+    TelemetryChannel sensor{"sensor_data", "SensorData", {
+        {"timestamp", F64}, {"acc_x", F64}, {"acc_y", F64}, {"acc_z", F64}, {"rpy_x", F64}, {"rpy_y", F64},
+        {"rpy_z", F64}, {"vel_z", F64}, {"hip_joint_pos", F64}, {"knee_joint_pos", F64}}};
+    TelemetryChannel debug{"debug_data", "DebugData", {
+        {"timestamp", F64}, {"DebugData1", F64}, {"DebugData2", F64}, {"DebugData3", F64},
+        {"DebugData4", F64}, {"DebugData5", F64}, {"DebugData6", F64}}};
+
+    bool gated = false;     // skip channels without subscribers, as Contact_Detection does
+    bool due(TelemetryChannel& ch) { return ch.tick() && (!gated || ch.subscribed()); }
+
+    // same order and decimation test as Contact_Detection
+    size_t publishAll(const TickData& d) {
+        size_t bytes = 0;
+        if (due(contact)) {
+            contact.write(d.t, d.isContact, d.probability, d.truth);
+            publish(contact.data(), contact.size());
+            bytes += contact.size();
+        }
+        if (due(input)) {
+            input.write(d.t, d.input[0], d.input[1], d.input[2], d.input[3], d.input[4]);
+            publish(input.data(), input.size());
+            bytes += input.size();
+        }
+        if (due(sensor)) {
+            const auto& s = d.sensor;
+            sensor.write(d.t, s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7], s[8]);
+            publish(sensor.data(), sensor.size());
+            bytes += sensor.size();
+        }
+        if (due(debug)) {
+            const auto& g = d.debug;
+            debug.write(d.t, g[0], g[1], g[2], g[3], g[4], g[5]);
+            publish(debug.data(), debug.size());
+            bytes += debug.size();
+        }
+        return bytes;
+    }
+};
+
+struct RunResult {
+    double nsPerTick{0};
+    double allocPerTick{0};
+    double bytesPerTick{0};
+};
+
+template<typename Func>
+static RunResult run(const std::vector<TickData>& ticks, Func&& func, int repeat = 5) {
+    RunResult best;
+    best.nsPerTick = 1e30;
+    for (int r = 0; r < repeat; r++) {
+        size_t bytes = 0;
+        const size_t alloc0 = allocations;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const TickData& d : ticks)
+            bytes += func(d);
+        auto end = std::chrono::high_resolution_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / ticks.size();
+        if (ns < best.nsPerTick) {
+            best.nsPerTick = ns;
+            best.allocPerTick = double(allocations - alloc0) / ticks.size();
+            best.bytesPerTick = double(bytes) / ticks.size();
+        }
+    }
+    return best;
+}
+
+// decode a ros1 payload with the schema field list and compare with the values written
+static bool checkDecode(const std::vector<TickData>& ticks) {
+    Channels ch;
+    size_t mismatch = 0;
+    for (size_t k = 0; k < 1000; k++) {
+        const TickData& d = ticks[k];
+        ch.contact.write(d.t, d.isContact, d.probability, d.truth);
+        ch.sensor.write(d.t, d.sensor[0], d.sensor[1], d.sensor[2], d.sensor[3], d.sensor[4], d.sensor[5],
+                        d.sensor[6], d.sensor[7], d.sensor[8]);
+        const uint8_t* p = ch.contact.data();
+        double t, prob;
+        std::memcpy(&t, p, 8);
+        std::memcpy(&prob, p + 9, 8);
+        mismatch += t != d.t || (p[8] != 0) != d.isContact || prob != d.probability || (p[17] != 0) != d.truth;
+        mismatch += ch.contact.size() != 18;
+        for (int i = 0; i < 9; i++) {
+            double v;
+            std::memcpy(&v, ch.sensor.data() + 8 * (i + 1), 8);
+            mismatch += v != d.sensor[i];
+        }
+    }
+    const bool ok = mismatch == 0 && ch.contact.schema() == "float64 timestamp\nbool is_contact\n"
+                                                            "float64 probability\nbool contact_truth\n";
+    printf("[telemetry] ros1 payload decode: 1000 ticks, mismatches %zu %s\n", mismatch, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// only subscribed channels are encoded, a decimation change applies from the next tick
+static bool checkSubscriptions(const std::vector<TickData>& ticks) {
+    Channels ch;
+    ch.gated = true;
+    ch.contact.subscribe();
+    ch.contact.subscribe();
+    ch.contact.unsubscribe();
+    ch.debug.unsubscribe();     // unmatched unsubscribe must not go negative
+    for (size_t k = 0; k < 100; k++)
+        ch.publishAll(ticks[k]);
+    ch.contact.setDecimation(5);
+    for (size_t k = 100; k < 200; k++)
+        ch.publishAll(ticks[k]);
+    ch.contact.unsubscribe();
+    for (size_t k = 200; k < 300; k++)
+        ch.publishAll(ticks[k]);
+    const bool ok = ch.contact.written() == 100 + 20 && ch.input.written() == 0 && ch.sensor.written() == 0 &&
+                    ch.debug.written() == 0 && ch.contact.subscribers() == 0 && ch.debug.subscribers() == 0;
+    printf("[telemetry] subscription gating: contact %llu messages (expected 120), others %llu %s\n",
+           (unsigned long long)ch.contact.written(),
+           (unsigned long long)(ch.input.written() + ch.sensor.written() + ch.debug.written()), ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// push the ticks at roughly 1 kHz bursts into a publisher, sinkNs simulates a slow websocket
+static bool checkPublisher(const std::vector<TickData>& ticks, uint64_t sinkNs, const char* name) {
+    struct Sample {
+        uint64_t seq;
+        TickData d;
+    };
+    uint64_t expected = 0, outOfOrder = 0, received = 0;
+    TelemetryPublisher<Sample, 1024> publisher([&](const Sample* s, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            outOfOrder += s[i].seq < expected;
+            expected = s[i].seq + 1;
+            received++;
+        }
+        if (sinkNs > 0)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(sinkNs * n));
+    }, 64, 200);
+    publisher.start();
+    double worstNs = 0, totalNs = 0;
+    const size_t n = std::min<size_t>(ticks.size(), 20000);
+    for (size_t k = 0; k < n; k++) {
+        Sample s{k, ticks[k]};
+        auto start = std::chrono::high_resolution_clock::now();
+        publisher.push(s);
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+        totalNs += ns;
+        worstNs = std::max(worstNs, ns);
+        if (k % 100 == 99)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    publisher.stop();
+    const bool ok = outOfOrder == 0 && received == publisher.sent() &&
+                    publisher.pushed() == publisher.sent() + publisher.dropped() && publisher.pushed() == n &&
+                    (sinkNs > 0 || publisher.dropped() == 0);
+    printf("[telemetry] publisher, %s: push %.0f ns avg %.0f ns worst, %llu pushed %llu sent %llu dropped in %llu "
+           "batches, out of order %llu %s\n", name, totalNs / n, worstNs,
+           (unsigned long long)publisher.pushed(), (unsigned long long)publisher.sent(),
+           (unsigned long long)publisher.dropped(), (unsigned long long)publisher.batches(),
+           (unsigned long long)outOfOrder, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+// walk_mpc_wbc --telemetry-udp path with a local receiver instead of PlotJuggler
+static bool checkDataBusStream(size_t n) {
+    int rx = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvBuf = 8 << 20;
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    timeval timeout{0, 200000};
+    setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (rx < 0 || bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0) {
+        printf("[telemetry] DataBus stream: no loopback socket FAIL\n");
+        return false;
+    }
+
+    std::vector<std::string> datagrams;
+    std::thread receiver([&]() {
+        char buf[2048];
+        while (true) {
+            ssize_t len = recv(rx, buf, sizeof(buf), 0);
+            if (len <= 0)
+                break;      // timeout after the last sample
+            datagrams.emplace_back(buf, len);
+        }
+    });
+
+    std::mt19937 gen(13);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    DataBus robotState(37);
+    std::vector<DataBusSample> pushedSamples(n);
+    DataBusUdpSink sink("127.0.0.1", ntohs(addr.sin_port));
+    TelemetryPublisher<DataBusSample> publisher([&](const DataBusSample* samples, size_t num) { sink(samples, num); });
+    publisher.start();
+    for (size_t k = 0; k < n; k++) {
+        for (int i = 0; i < 3; i++) {
+            robotState.q(i) = u(gen);
+            robotState.base_rpy(i) = 0.1 * u(gen);
+            robotState.dq(i) = u(gen);
+            robotState.fe_l_pos_W(i) = u(gen);
+            robotState.fe_r_pos_W(i) = u(gen);
+        }
+        robotState.fLcontactProb = 0.5 + 0.5 * u(gen);
+        robotState.fRcontactProb = 0.5 + 0.5 * u(gen);
+        robotState.legState = (k / 400) % 2 ? DataBus::LSt : DataBus::RSt;
+        robotState.motionState = DataBus::Walk;
+        fillDataBusSample(robotState, k * 0.001, pushedSamples[k]);
+        publisher.push(pushedSamples[k]);
+        if (k % 16 == 15)   // 1 kHz on average, in bursts as mj_step runs between two rendered frames
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+    publisher.stop();
+    receiver.join();
+    close(rx);
+
+    // datagrams follow the push order, a dropped sample is skipped by its time stamp
+    size_t mismatch = 0, next = 0;
+    auto near = [](const nlohmann::json& a, const double* b, int num) {   // %.6g formatting
+        for (int i = 0; i < num; i++)
+            if (std::abs(a[i].get<double>() - b[i]) > 1e-5 * std::max(1.0, std::abs(b[i])))
+                return false;
+        return true;
+    };
+    for (const std::string& d : datagrams) {
+        nlohmann::json j = nlohmann::json::parse(d, nullptr, false);
+        if (j.is_discarded()) {
+            mismatch++;
+            continue;
+        }
+        const size_t k = static_cast<size_t>(std::llround(j["t"].get<double>() * 1000.0));
+        if (k < next || k >= n) {
+            mismatch++;
+            continue;
+        }
+        next = k + 1;
+        const DataBusSample& s = pushedSamples[k];
+        const double prob[2] = {s.fLcontactProb, s.fRcontactProb};
+        if (!near(j["base_pos"], s.basePos, 3) || !near(j["base_rpy"], s.baseRpy, 3) ||
+            !near(j["base_vel"], s.baseLinVel, 3) || !near(j["fe_l_pos"], s.feLPos, 3) ||
+            !near(j["fe_r_pos"], s.feRPos, 3) || !near(j["contact_prob"], prob, 2) ||
+            j["leg_state"].get<int>() != s.legState || j["motion_state"].get<int>() != s.motionState)
+            mismatch++;
+    }
+    const bool ok = mismatch == 0 && sink.sendErrorNum() == 0 && datagrams.size() == publisher.sent() &&
+                    publisher.dropped() == 0 && publisher.pushed() == n;
+    printf("[telemetry] DataBus stream over udp: %llu pushed %llu sent %llu dropped, %zu received, mismatches %zu %s\n",
+           (unsigned long long)publisher.pushed(), (unsigned long long)publisher.sent(),
+           (unsigned long long)publisher.dropped(), datagrams.size(), mismatch, ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+int main() {
+    const size_t tickNum = 100000;
+    const std::vector<TickData> ticks = makeTicks(tickNum);
+    bool pass = checkDecode(ticks);
+    pass = checkSubscriptions(ticks) && pass;
+    pass = checkPublisher(ticks, 0, "fast sink") && pass;
+    pass = checkPublisher(ticks, 20000, "stalled sink") && pass;
+    pass = checkDataBusStream(2000) && pass;
+
+    RunResult json = run(ticks, publishJson);
+    Channels every;
+    RunResult binary = run(ticks, [&](const TickData& d) { return every.publishAll(d); });
+    Channels decimated;
+    decimated.sensor.setDecimation(4);
+    decimated.debug.setDecimation(10);
+    RunResult binaryDecimated = run(ticks, [&](const TickData& d) { return decimated.publishAll(d); });
+    Channels unobserved;
+    unobserved.gated = true;
+    RunResult binaryUnobserved = run(ticks, [&](const TickData& d) { return unobserved.publishAll(d); });
+
+    printf("[telemetry] %zu ticks, 4 channels, payloads to a sink instead of broadcastMessage\n", tickNum);
+    printf("  json objects + dump()      : %8.1f ns/tick, %5.1f allocations/tick, %6.1f bytes/tick\n",
+           json.nsPerTick, json.allocPerTick, json.bytesPerTick);
+    printf("  ros1 binary, every tick    : %8.1f ns/tick, %5.1f allocations/tick, %6.1f bytes/tick (x%.0f faster)\n",
+           binary.nsPerTick, binary.allocPerTick, binary.bytesPerTick, json.nsPerTick / binary.nsPerTick);
+    printf("  ros1 binary, sensor/4 dbg/10: %7.1f ns/tick, %5.1f allocations/tick, %6.1f bytes/tick (x%.0f faster)\n",
+           binaryDecimated.nsPerTick, binaryDecimated.allocPerTick, binaryDecimated.bytesPerTick,
+           json.nsPerTick / binaryDecimated.nsPerTick);
+    printf("  ros1 binary, no subscribers: %6.1f ns/tick, %5.1f allocations/tick, %6.1f bytes/tick\n",
+           binaryUnobserved.nsPerTick, binaryUnobserved.allocPerTick, binaryUnobserved.bytesPerTick);
+
+    return pass && binary.allocPerTick == 0 ? 0 : 1;
+}
@@ -19,84 +19,17 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
 #include "gait_scheduler.h"
 #include "foot_placement.h"
 #include "joystick_interpreter.h"
+#include "Contact_Estimator.h"
+#include "latency_stats.h"
 #include <string>
 #include <iostream>
-#include <sys/shm.h>
-#include <sys/stat.h>
 #include <sys/resource.h>
-
-// 定义与主进程相同的共享内存结构
-struct SharedRobotData {
-    double simTime;
-    double lF_pos[3];
-    double lF_acc[3];
-    double lF_rpy[3];
-    double lF_angular_vel[3];
-    double lF_linear_vel[3];
-    double hip_joint_pos;
-    double knee_joint_pos;
-    double Contactforce;
-    // ...其他需要的数据
-    int dataReady;  // 数据就绪标志
-};
-// 创建共享内存的函数
-SharedRobotData* setupSharedMemory() {
-    // 确保键值文件存在
-    FILE* fp = fopen("/tmp/openloong_shm_key", "w");
-    if (fp) fclose(fp);
-    // 创建共享内存
-    key_t key = ftok("/tmp/openloong_shm_key", 'R');
-    if (key == -1) {
-        perror("ftok failed");
-        return nullptr;
-    }
-
-    // // 检查是否存在旧的共享内存段，如果存在则移除
-    // int existing_shmid = shmget(key, 0, 0666);
-    // if (existing_shmid >= 0) {
-    //     std::cout << "发现已存在的共享内存段，正在移除..." << std::endl;
-    //     if (shmctl(existing_shmid, IPC_RMID, NULL) == -1) {
-    //         perror("移除共享内存段失败");
-    //     } else {
-    //         std::cout << "已成功移除旧共享内存段" << std::endl;
-    //     }
-    // }
-    
-    size_t shm_size = sizeof(SharedRobotData);
-    std::cout << "共享内存大小: " << shm_size << " 字节" << std::endl;
-    std::cout << "共享内存键值: " << key << std::endl;
-
-    int shmid = shmget(key, shm_size, IPC_CREAT | IPC_EXCL | 0666);
-    if (shmid < 0) {
-        if (errno == EEXIST) {
-            // 共享内存已存在，尝试获取它
-            shmid = shmget(key, shm_size, 0666);
-            if (shmid < 0) {
-                perror("shmget (existing) failed");
-                return nullptr;
-            }
-            std::cout << "使用现有共享内存段: " << shmid << std::endl;
-        } else {
-            perror("shmget failed");
-            std::cout << "错误号: " << errno << std::endl;
-            return nullptr;
-        }
-    } else {
-        std::cout << "创建新共享内存段: " << shmid << std::endl;
-    }
-    
-    // 附加共享内存
-    SharedRobotData* data = (SharedRobotData*)shmat(shmid, NULL, 0);
-    if (data == (void*)-1) {
-        perror("shmat failed");
-        return nullptr;
-    }
-    // 初始化数据
-    memset(data, 0, shm_size);
-    // 初始化数据
-    data->dataReady = 0;
-    return data;
-}
+#include <csignal>
+#include "shared_robot_data.h"
+#include "telemetry_publisher.h"
+#include "databus_telemetry.h"
+#include <memory>
+#include <cstdlib>
 
 const   double  dt = 0.001;
 const   double  dt_200Hz = 0.005;
@@ -105,11 +38,21 @@ char error[1000] = "Could not load binary model";
 mjModel* mj_model = mj_loadXML("../models/scene.xml", 0, error, 1000);
 mjData* mj_data = mj_makeData(mj_model);
 
+// Ctrl+C / kill: leave the loop so the shared memory is unlinked and the statistics are printed
+volatile sig_atomic_t stopRequested = 0;
+void signalHandler(int signum) {
+    stopRequested = 1;
+}
+
 int main(int argc, char **argv) {
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
     
-    // 在main()函数内创建共享内存
-    SharedRobotData* sharedData;
-    sharedData = setupSharedMemory();
+    // 创建共享内存环形缓冲区，外部进程（如Contact_detection）按序号读取每个控制周期的数据
+    RobotDataRing robotDataRing;
+    if (robotDataRing.create(robotDataShmName))
+        std::cout << "共享内存: " << robotDataShmName << ", 每帧 " << sizeof(SharedRobotData) << " 字节" << std::endl;
+    SharedRobotData sharedFrame{};
 
     // initialize classes
     UIctr uiController(mj_model,mj_data);   // UI control for Mujoco
@@ -123,6 +66,7 @@ int main(int argc, char **argv) {
     FootPlacement footPlacement; // foot-placement planner
     JoyStickInterpreter jsInterp(mj_model->opt.timestep); // desired baselink velocity generator
     DataLogger logger("../record/datalog.log"); // data logger
+    ContactEstimator contactEstimator(2, 100); // foot contact estimation, left and right foot
 
     // initialize UI: GLFW
     uiController.iniGLFW();
@@ -142,6 +86,36 @@ int main(int argc, char **argv) {
     footPlacement.stepHeight = 0.2;
     footPlacement.legLength=stand_legLength;
 
+    bool contactInProcess = true; // run contact estimation inside the control loop, results go to the data bus
+    gaitScheduler.useContactEst = false; // set true to let the gait scheduler switch legs on the estimated contact
+    LatencyStats contactLatency; // sensor write to contact estimate available
+
+    // WBC torque QP: cold init every tick as before, --wbc-warm hotstarts from the previous active set to compare
+    // --telemetry-udp <port>: stream a few DataBus signals as JSON datagrams to 127.0.0.1:<port> (e.g. PlotJuggler)
+    int telemetryPort = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--wbc-warm")
+            WBC_solv.useWarmStart = true;
+        else if (arg == "--telemetry-udp" && i + 1 < argc)
+            telemetryPort = std::atoi(argv[++i]);
+    }
+    LatencyStats wbcSolveTime; // qpOASES cpu time per tick, a failed hotstart plus its cold init counted together
+    LatencyStats wbcNWSR;      // working set recalculations per tick
+
+    // live DataBus stream, formatted and sent on the publisher thread; may drop samples, the datalog does not
+    std::unique_ptr<DataBusUdpSink> telemetrySink;
+    std::unique_ptr<TelemetryPublisher<DataBusSample>> telemetry;
+    DataBusSample telemetrySample{};
+    if (telemetryPort > 0 && telemetryPort < 65536) {
+        telemetrySink.reset(new DataBusUdpSink("127.0.0.1", static_cast<uint16_t>(telemetryPort)));
+        telemetry.reset(new TelemetryPublisher<DataBusSample>([&](const DataBusSample *samples, size_t n) {
+            (*telemetrySink)(samples, n);
+        }));
+        telemetry->start();
+        std::cout << "DataBus telemetry: udp 127.0.0.1:" << telemetryPort << std::endl;
+    }
+
     mju_copy(mj_data->qpos, mj_model->key_qpos, mj_model->nq*1); // set ini pos in Mujoco
 
     std::vector<double> motors_pos_des(model_nv - 6, 0);
@@ -220,7 +194,7 @@ int main(int argc, char **argv) {
     mjtNum simstart = mj_data->time;
     double simTime = mj_data->time;
 
-    while (!glfwWindowShouldClose(uiController.window)) {
+    while (!glfwWindowShouldClose(uiController.window) && !stopRequested) {
         simstart = mj_data->time;
         while (mj_data->time - simstart < 1.0 / 60.0 && uiController.runSim) { // press "1" to pause and resume, "2" to step the simulation
             mj_step(mj_model, mj_data);
@@ -229,6 +203,15 @@ int main(int argc, char **argv) {
             mj_interface.updateSensorValues();
             mj_interface.dataBusWrite(RobotState);
 
+            // foot contact estimation, right after the sensors are on the bus
+            if (contactInProcess) {
+                uint64_t sensorStamp = LatencyStats::nowNs();
+                contactEstimator.dataBusRead(RobotState);
+                contactEstimator.step();
+                contactEstimator.dataBusWrite(RobotState);
+                contactLatency.add((LatencyStats::nowNs() - sensorStamp) * 1e-3);
+            }
+
             // update kinematics and dynamics info
             kinDynSolver.dataBusRead(RobotState);
             kinDynSolver.computeJ_dJ();
@@ -273,6 +256,8 @@ int main(int argc, char **argv) {
             WBC_solv.computeDdq(kinDynSolver);
             WBC_solv.computeTau();
             WBC_solv.dataBusWrite(RobotState);
+            wbcSolveTime.add(WBC_solv.lastCpuTime() * 1e6);
+            wbcNWSR.add(WBC_solv.lastNWSR());
             // get the final joint command
             if (simTime <= startSteppingTime) {
                 RobotState.motors_pos_des = eigen2std(resLeg.jointPosRes + resHand.jointPosRes);
@@ -363,29 +348,35 @@ int main(int argc, char **argv) {
             
 			logger.finishLine();
 
+            if (telemetry) {
+                fillDataBusSample(RobotState, simTime, telemetrySample);
+                telemetry->push(telemetrySample);
+            }
+
             // Sharememory update
-            if (sharedData) {
-                sharedData->simTime = simTime;
-                sharedData->lF_pos[0] = RobotState.fLPos[0];
-                sharedData->lF_pos[1] = RobotState.fLPos[1];
-                sharedData->lF_pos[2] = RobotState.fLPos[2];
-                sharedData->lF_acc[0] = RobotState.fLAcc[0];
-                sharedData->lF_acc[1] = RobotState.fLAcc[1];
-                sharedData->lF_acc[2] = RobotState.fLAcc[2];
-                sharedData->lF_rpy[0] = RobotState.fLrpy[0];
-                sharedData->lF_rpy[1] = RobotState.fLrpy[1];
-                sharedData->lF_rpy[2] = RobotState.fLrpy[2];
-                sharedData->lF_angular_vel[0] = RobotState.fLAngVel[0];
-                sharedData->lF_angular_vel[1] = RobotState.fLAngVel[1];
-                sharedData->lF_angular_vel[2] = RobotState.fLAngVel[2];
-                sharedData->lF_linear_vel[0] = RobotState.fLLinVel[0];
-                sharedData->lF_linear_vel[1] = RobotState.fLLinVel[1];
-                sharedData->lF_linear_vel[2] = RobotState.fLLinVel[2];
-                sharedData->hip_joint_pos = RobotState.q(7);
-                sharedData->knee_joint_pos = RobotState.q(18);
-                sharedData->Contactforce = RobotState.fLtouch;
+            if (robotDataRing.valid()) {
+                sharedFrame.simTime = simTime;
+                sharedFrame.lF_pos[0] = RobotState.fLPos[0];
+                sharedFrame.lF_pos[1] = RobotState.fLPos[1];
+                sharedFrame.lF_pos[2] = RobotState.fLPos[2];
+                sharedFrame.lF_acc[0] = RobotState.fLAcc[0];
+                sharedFrame.lF_acc[1] = RobotState.fLAcc[1];
+                sharedFrame.lF_acc[2] = RobotState.fLAcc[2];
+                sharedFrame.lF_rpy[0] = RobotState.fLrpy[0];
+                sharedFrame.lF_rpy[1] = RobotState.fLrpy[1];
+                sharedFrame.lF_rpy[2] = RobotState.fLrpy[2];
+                sharedFrame.lF_angular_vel[0] = RobotState.fLAngVel[0];
+                sharedFrame.lF_angular_vel[1] = RobotState.fLAngVel[1];
+                sharedFrame.lF_angular_vel[2] = RobotState.fLAngVel[2];
+                sharedFrame.lF_linear_vel[0] = RobotState.fLLinVel[0];
+                sharedFrame.lF_linear_vel[1] = RobotState.fLLinVel[1];
+                sharedFrame.lF_linear_vel[2] = RobotState.fLLinVel[2];
+                sharedFrame.hip_joint_pos = RobotState.q(7);
+                sharedFrame.knee_joint_pos = RobotState.q(18);
+                sharedFrame.Contactforce = RobotState.fLtouch;
+                sharedFrame.writeStampNs = LatencyStats::nowNs();
                 // // ...其他需要共享的数据
-                sharedData->dataReady = 1;  // 标记数据已就绪
+                robotDataRing.publish(sharedFrame);
             }
 
         }
@@ -395,8 +386,27 @@ int main(int argc, char **argv) {
 
         uiController.updateScene();
     };
+    // remove the shared memory name, a reader started later must not attach to the frames of this run;
+    // readers still attached keep their mapping
+    if (robotDataRing.valid()) {
+        robotDataRing.detach();
+        RobotDataRing::unlink(robotDataShmName);
+    }
     // free visualization storage
     uiController.Close();
 
+    if (contactInProcess)
+        contactLatency.print("in-process contact latency");
+    wbcSolveTime.print(WBC_solv.useWarmStart ? "WBC QP solve, warm start" : "WBC QP solve, cold init");
+    printf("WBC QP nWSR: mean=%.2f p50=%.0f p99=%.0f max=%.0f, %ld hotstarts, %ld cold inits, %ld hotstart failures\n",
+           wbcNWSR.mean(), wbcNWSR.percentile(50), wbcNWSR.percentile(99), wbcNWSR.max(),
+           WBC_solv.hotstartNum(), WBC_solv.coldInitNum(), WBC_solv.hotstartFailNum());
+    if (telemetry) {
+        telemetry->stop();
+        printf("DataBus telemetry: pushed %llu, sent %llu, dropped %llu, send errors %llu\n",
+               (unsigned long long) telemetry->pushed(), (unsigned long long) telemetry->sent(),
+               (unsigned long long) telemetry->dropped(), (unsigned long long) telemetrySink->sendErrorNum());
+    }
+
     return 0;
 }
@@ -16,6 +16,63 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
 #include "foot_placement.h"
 #include "joystick_interpreter.h"
 #include <chrono>
+#include <cstdlib>
+#include <cstddef>
+#include <cerrno>
+
+// test hook: counts heap allocations of this thread while allocCounting is set, to check the WBC QP data path is
+// allocation free. Counted at the malloc level (glibc symbol interposition), which operator new and Eigen's
+// aligned_malloc both end up in; the quill backend and other threads are not counted.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+static thread_local bool allocCounting = false;
+static thread_local size_t allocCount = 0;
+
+static bool isPowerOfTwo(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+extern "C" {
+void* malloc(size_t size) {
+    if (allocCounting)
+        allocCount++;
+    return __libc_malloc(size);
+}
+void* calloc(size_t n, size_t size) {
+    if (allocCounting)
+        allocCount++;
+    return __libc_calloc(n, size);
+}
+void* realloc(void* p, size_t size) {
+    if (allocCounting)
+        allocCount++;
+    return __libc_realloc(p, size);
+}
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (allocCounting)
+        allocCount++;
+    if (!isPowerOfTwo(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return __libc_memalign(alignment, size);
+}
+int posix_memalign(void** p, size_t alignment, size_t size) {
+    if (allocCounting)
+        allocCount++;
+    if (!isPowerOfTwo(alignment) || alignment % sizeof(void*) != 0)
+        return EINVAL;  // *p is left unmodified
+    void* mem = __libc_memalign(alignment, size);
+    if (!mem && size != 0)
+        return ENOMEM;
+    *p = mem;
+    return 0;
+}
+}
 
 // main function
 int main(int argc, const char **argv) {
@@ -95,6 +152,7 @@ int main(int argc, const char **argv) {
                                      -0.0001, 0.0000, -0.0006, 0.0002, 0.0003, -0.0009, 0.0002, -0.0002, -0.0002,
                                      -0.0001, 0.0008};
     const int LoopNum=10000;
+    size_t buildAllocs = 0, solveAllocs = 0; // after the first tick
     auto start = std::chrono::high_resolution_clock::now();
     auto end = std::chrono::high_resolution_clock::now();
     for (int LoopCount = 0; LoopCount < LoopNum; LoopCount++) {
@@ -180,7 +238,14 @@ int main(int argc, const char **argv) {
         // WBC Calculation
         WBC_solv.dataBusRead(RobotState);
         WBC_solv.computeDdq(kinDynSolver);
-        WBC_solv.computeTau();
+        allocCount = 0;
+        allocCounting = LoopCount > 0;
+        WBC_solv.buildTauQP();
+        buildAllocs += allocCount;
+        allocCount = 0;
+        WBC_solv.solveTauQP();  // qpOASES itself allocates its matrix wrappers on every init/hotstart
+        solveAllocs += allocCount;
+        allocCounting = false;
         WBC_solv.dataBusWrite(RobotState);
 //
 //        // get the final joint command
@@ -230,8 +295,10 @@ int main(int argc, const char **argv) {
 
     std::chrono::duration<double> duration = end - start;
     std::cout<<"loop time recorded to the last column of record/datalog.log"<<std::endl;
+    printf("WBC QP assembly: %.2f allocations/tick %s, solve incl. qpOASES: %.2f allocations/tick\n",
+           double(buildAllocs) / (LoopNum - 1), buildAllocs == 0 ? "PASS" : "FAIL", double(solveAllocs) / (LoopNum - 1));
 
 //    std::cout << "Ava Loop time: " << duration.count()/LoopNum*1000. << " ms\n";
 
-    return 0;
+    return buildAllocs == 0 ? 0 : 1;
 }
@@ -15,15 +15,17 @@ LPF_Fst::LPF_Fst() {
 }
 
 LPF_Fst::LPF_Fst(double fc, double Ts) {
-    alpha=Ts/(Ts+1.0/(2*3.1415*fc));
+    setPara(fc, Ts);
 }
 
+// res=(1-alpha)*dataOld+alpha*dataIn, the first input is passed through
 double LPF_Fst::ftOut(double dataIn) {
     double res{0};
     if (isIni)
-        res=(1-alpha)*dataOld+alpha*dataIn;
+        lpf.process(&dataIn, &res);
     else{
         res=dataIn;
+        lpf.reset(&dataIn);
         isIni=true;
     }
     dataOld=res;
@@ -32,4 +34,7 @@ double LPF_Fst::ftOut(double dataIn) {
 
 void LPF_Fst::setPara(double fc, double Ts) {
     alpha=Ts/(Ts+1.0/(2*3.1415*fc));
+    lpf.setSections({BiquadBank::exponentialSmoothing(alpha)});
+    if (isIni)
+        lpf.reset(&dataOld);    // filter state is (1-alpha)*dataOld
 }
\ No newline at end of file
@@ -8,12 +8,14 @@ Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any styl
 
 #pragma once
 
+#include "biquad_bank.h"
 
 class LPF_Fst {
 private:
     double alpha{0};
     double dataOld{0};
     bool isIni{false};
+    BiquadBank lpf{1, 1};   // one channel, one first-order section
 public:
     LPF_Fst();
     LPF_Fst(double fc,double Ts);
@@ -0,0 +1,147 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+#include "biquad_bank.h"
+#include "Eigen/Dense"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+BiquadBank::BiquadBank() = default;
+
+BiquadBank::BiquadBank(int channelNum, int sectionNum) {
+    resize(channelNum, sectionNum);
+}
+
+BiquadBank::BiquadBank(int channelNum, const std::vector<Section> &sos) {
+    resize(channelNum, static_cast<int>(sos.size()));
+    setSections(sos);
+}
+
+void BiquadBank::resize(int channelNum, int sectionNum) {
+    if (channelNum < 0 || sectionNum < 0)
+        throw std::invalid_argument("BiquadBank size must not be negative");
+    chNum = channelNum;
+    secNum = sectionNum;
+    const size_t n = size_t(chNum) * secNum;
+    b0.assign(n, 1.0);
+    b1.assign(n, 0.0);
+    b2.assign(n, 0.0);
+    a1.assign(n, 0.0);
+    a2.assign(n, 0.0);
+    s1.assign(n, 0.0);
+    s2.assign(n, 0.0);
+}
+
+void BiquadBank::setSections(const std::vector<Section> &sos) {
+    if (static_cast<int>(sos.size()) != secNum)
+        resize(chNum, static_cast<int>(sos.size()));
+    for (int ch = 0; ch < chNum; ch++)
+        setSections(ch, sos);
+}
+
+void BiquadBank::setSections(int channel, const std::vector<Section> &sos) {
+    if (channel < 0 || channel >= chNum)
+        throw std::out_of_range("BiquadBank channel out of range");
+    if (static_cast<int>(sos.size()) != secNum)
+        throw std::invalid_argument("Number of sections does not match BiquadBank");
+    for (int sec = 0; sec < secNum; sec++) {
+        const size_t idx = size_t(sec) * chNum + channel;
+        b0[idx] = sos[sec].b0;
+        b1[idx] = sos[sec].b1;
+        b2[idx] = sos[sec].b2;
+        a1[idx] = sos[sec].a1;
+        a2[idx] = sos[sec].a2;
+    }
+}
+
+void BiquadBank::reset() {
+    std::fill(s1.begin(), s1.end(), 0.0);
+    std::fill(s2.begin(), s2.end(), 0.0);
+}
+
+void BiquadBank::reset(const double *x0) {
+    // with unit DC gain input and output of every section stay at x0
+    for (int sec = 0; sec < secNum; sec++) {
+        for (int ch = 0; ch < chNum; ch++) {
+            const size_t idx = size_t(sec) * chNum + ch;
+            const double x = x0[ch];
+            s2[idx] = b2[idx] * x - a2[idx] * x;
+            s1[idx] = b1[idx] * x - a1[idx] * x + s2[idx];
+        }
+    }
+}
+
+void BiquadBank::process(const double *in, double *out) {
+    // blocks of channels stay in registers through the whole cascade
+    const int block = 8;
+    using Blk = Eigen::Array<double, block, 1>;
+    using BlkMap = Eigen::Map<Blk, Eigen::Unaligned>;
+    using ConstBlkMap = Eigen::Map<const Blk, Eigen::Unaligned>;
+
+    int ch = 0;
+    for (; ch + block <= chNum; ch += block) {
+        Blk x = ConstBlkMap(in + ch);
+        for (int sec = 0; sec < secNum; sec++) {
+            const size_t off = size_t(sec) * chNum + ch;
+            BlkMap S1(s1.data() + off), S2(s2.data() + off);
+            Blk yy = ConstBlkMap(b0.data() + off) * x + S1;
+            S1 = ConstBlkMap(b1.data() + off) * x - ConstBlkMap(a1.data() + off) * yy + S2;
+            S2 = ConstBlkMap(b2.data() + off) * x - ConstBlkMap(a2.data() + off) * yy;
+            x = yy;
+        }
+        BlkMap(out + ch) = x;
+    }
+    for (; ch < chNum; ch++) {
+        double x = in[ch];
+        for (int sec = 0; sec < secNum; sec++) {
+            const size_t idx = size_t(sec) * chNum + ch;
+            double yy = b0[idx] * x + s1[idx];
+            s1[idx] = b1[idx] * x - a1[idx] * yy + s2[idx];
+            s2[idx] = b2[idx] * x - a2[idx] * yy;
+            x = yy;
+        }
+        out[ch] = x;
+    }
+}
+
+std::vector<BiquadBank::Section> BiquadBank::butterworthLowPass(int order, double fc, double fs) {
+    if (order < 1)
+        throw std::invalid_argument("Butterworth order must be at least 1");
+    if (fc <= 0 || fc >= fs / 2)
+        throw std::invalid_argument("Cutoff frequency must be in (0, fs/2)");
+
+    const double ita = tan(M_PI * fc / fs);     // prewarped analog cutoff
+    std::vector<Section> sos;
+    for (int k = 0; k < order / 2; k++) {
+        // analog section s^2 + q*s + 1, q = 2*sin(pi*(2k+1)/(2*order))
+        const double q = 2.0 * sin(M_PI * (2 * k + 1) / (2.0 * order));
+        Section s;
+        s.b0 = ita * ita / (1 + q * ita + ita * ita);
+        s.b1 = 2 * s.b0;
+        s.b2 = s.b0;
+        s.a1 = 2 * (ita * ita - 1) / (1 + q * ita + ita * ita);
+        s.a2 = (1 - q * ita + ita * ita) / (1 + q * ita + ita * ita);
+        sos.push_back(s);
+    }
+    if (order % 2 == 1) {
+        Section s;
+        s.b0 = ita / (1 + ita);
+        s.b1 = s.b0;
+        s.a1 = (ita - 1) / (1 + ita);
+        sos.push_back(s);
+    }
+    return sos;
+}
+
+BiquadBank::Section BiquadBank::exponentialSmoothing(double alpha) {
+    Section s;
+    s.b0 = alpha;
+    s.a1 = -(1 - alpha);
+    return s;
+}
@@ -0,0 +1,58 @@
+/*
+This is part of OpenLoong Dynamics Control, an open project for the control of biped robot,
+Copyright (C) 2024 Humanoid Robot (Shanghai) Co., Ltd, under Apache 2.0.
+Feel free to use in any purpose, and cite OpenLoong-Dynamics-Control in any style, to contribute to the advancement of the community.
+ <https://atomgit.com/openloong/openloong-dyn-control.git>
+ <web@openloong.org.cn>
+*/
+
+// Bank of IIR filters, one per channel, each a cascade of biquad sections (second-order sections, SOS)
+// in Direct Form II Transposed. Coefficients and states are stored section by section with all channels
+// contiguous. process() runs blocks of 8 channels through the whole cascade with SIMD across the channels,
+// the remaining channels one by one.
+// Channels may have different coefficients but share the number of sections.
+//
+#pragma once
+
+#include <vector>
+
+class BiquadBank {
+public:
+    // y = b0*x + s1, s1 = b1*x - a1*y + s2, s2 = b2*x - a2*y, a0 is 1
+    struct Section {
+        double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};
+    };
+
+    BiquadBank();
+    BiquadBank(int channelNum, int sectionNum);
+    BiquadBank(int channelNum, const std::vector<Section> &sos);
+
+    // sections are pass-through and states zero after resize
+    void resize(int channelNum, int sectionNum);
+    // same cascade for all channels, resizes to sos.size() sections
+    void setSections(const std::vector<Section> &sos);
+    // cascade of one channel, sos.size() must be sectionNum
+    void setSections(int channel, const std::vector<Section> &sos);
+
+    // zero states
+    void reset();
+    // states as if every channel had seen the constant input x0[ch] forever, assumes unit DC gain
+    void reset(const double *x0);
+
+    // filter one sample of every channel, in and out hold channelNum values and may be the same
+    void process(const double *in, double *out);
+
+    int channels() const { return chNum; }
+    int sections() const { return secNum; }
+
+    // Butterworth low-pass of any order, bilinear transform with prewarping, odd orders end with a first-order section
+    static std::vector<Section> butterworthLowPass(int order, double fc, double fs);
+    // first-order smoothing y = (1-alpha)*y + alpha*x
+    static Section exponentialSmoothing(double alpha);
+
+private:
+    int chNum{0}, secNum{0};
+    // index sec*chNum + ch
+    std::vector<double> b0, b1, b2, a1, a2;
+    std::vector<double> s1, s2;
+};